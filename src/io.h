@@ -29,4 +29,32 @@ static inline uint16_t inw(uint16_t port) {
     return ret;
 }
 
+// 더블워드 (32비트) 출력
+static inline void outl(uint16_t port, uint32_t val) {
+    __asm__ volatile ("outl %0, %1" : : "a"(val), "Nd"(port));
+}
+
+// 더블워드 (32비트) 입력
+static inline uint32_t inl(uint16_t port) {
+    uint32_t ret;
+    __asm__ volatile ("inl %1, %0" : "=a"(ret) : "Nd"(port));
+    return ret;
+}
+
+// 타임스탬프 카운터 읽기
+static inline uint64_t rdtsc() {
+    uint32_t lo, hi;
+    __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// 64비트 ÷ 32비트 (libgcc 의 __udivdi3 없이 divl 두 번, rem 은 NULL 가능)
+static inline uint64_t udiv64_32(uint64_t n, uint32_t d, uint32_t* rem) {
+    uint32_t hi = (uint32_t)(n >> 32), lo = (uint32_t)n;
+    uint32_t qhi = hi / d, r = hi % d, qlo;
+    __asm__ ("divl %4" : "=a"(qlo), "=d"(r) : "a"(lo), "d"(r), "rm"(d));
+    if (rem) *rem = r;
+    return ((uint64_t)qhi << 32) | qlo;
+}
+
 #endif // NEUIX_IO_H
@@ -1,9 +1,12 @@
+#include "neuix_mem.h"
 #include "neuix_vga.h"
 #include "neuix_keyboard.h"
 #include "neuix_fs.h"
+#include "neuix_syscall.h"
 #include "neuix_userland.h"
 
 void kernel_main() {
+    mem_init();       // CPUID 로 memcpy/memset 구현 선택
     vga_set_color(COLOR_WHITE, COLOR_BLACK);
     vga_clear();
     vga_write("contact to kdywkrrk@gmail.com\n");
@@ -11,8 +14,10 @@ void kernel_main() {
     vga_write("Neuix 1.2 booted\n");
 
     fs_init();        // 파일시스템 초기화
+    syscall_init();   // int 0x80 시스템 콜 게이트
     keyboard_init();  // 키보드 초기화 (필요시)
 
+    sh_autorun();     // /root/autorun.sh 가 있으면 실행
     login();          // 로그인
     userland();       // 쉘 시작
 
@@ -0,0 +1,377 @@
+// neuix_ahci.h – AHCI SATA 드라이버 (폴링, NCQ 지원)
+//
+// PCI class 01:06:01 컨트롤러의 첫 번째 SATA 디스크 포트를 사용한다.
+// 드라이브와 HBA 가 NCQ 를 지원하면 READ/WRITE FPDMA QUEUED 로 최대 32개 요청을
+// 동시에 띄우고, 아니면 READ/WRITE DMA EXT 를 명령 슬롯에 차례로 넣는다.
+// 커널은 페이징 없이 물리 주소 = 가상 주소라고 가정한다.
+
+#ifndef NEUIX_AHCI_H
+#define NEUIX_AHCI_H
+
+#include "io.h"
+#include "neuix_pci.h"
+#include "neuix_block.h"
+#include "neuix_mem.h"
+#include "neuix_vga.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define AHCI_MAX_SLOTS      32
+#define AHCI_PRDT_ENTRIES   8
+#define AHCI_PRD_MAX_BYTES  (4 * 1024 * 1024)   // PRD 하나의 최대 바이트 수
+#define AHCI_MAX_SECTORS    65535               // FIS 카운트 필드 16비트
+#define AHCI_BOUNCE_SECTORS 128                 // 홀수 주소 버퍼용
+#define AHCI_TIMEOUT        10000000
+
+#define AHCI_GHC_AE         (1u << 31)
+#define AHCI_GHC_IE         (1u << 1)
+#define AHCI_GHC_HR         (1u << 0)
+#define AHCI_CAP_SNCQ       (1u << 30)
+#define AHCI_CAP_SSS        (1u << 27)
+#define AHCI_CAP2_BOH       (1u << 0)
+#define AHCI_BOHC_BOS       (1u << 0)
+#define AHCI_BOHC_OOS       (1u << 1)
+#define AHCI_BOHC_BB        (1u << 4)
+#define AHCI_LINK_WAIT      10000               // 포트 0x80 쓰기 (약 1us) 횟수 = 약 10ms
+
+#define AHCI_PxCMD_ST       (1u << 0)
+#define AHCI_PxCMD_SUD      (1u << 1)
+#define AHCI_PxCMD_FRE      (1u << 4)
+#define AHCI_PxCMD_FR       (1u << 14)
+#define AHCI_PxCMD_CR       (1u << 15)
+#define AHCI_PxIS_TFES      (1u << 30)
+#define AHCI_PxTFD_BSY      (1u << 7)
+#define AHCI_PxTFD_DRQ      (1u << 3)
+#define AHCI_SIG_ATA        0x00000101
+
+#define FIS_TYPE_REG_H2D    0x27
+
+#define ATA_CMD_READ_DMA_EXT        0x25
+#define ATA_CMD_WRITE_DMA_EXT       0x35
+#define ATA_CMD_READ_FPDMA_QUEUED   0x60
+#define ATA_CMD_WRITE_FPDMA_QUEUED  0x61
+#define AHCI_CMD_IDENTIFY           0xEC
+
+typedef volatile struct {
+    uint32_t clb, clbu, fb, fbu;
+    uint32_t is, ie, cmd, rsv0;
+    uint32_t tfd, sig, ssts, sctl;
+    uint32_t serr, sact, ci, sntf;
+    uint32_t fbs;
+    uint32_t rsv1[11];
+    uint32_t vendor[4];
+} AhciPort;
+
+typedef volatile struct {
+    uint32_t cap, ghc, is, pi, vs;
+    uint32_t ccc_ctl, ccc_pts, em_loc, em_ctl, cap2, bohc;
+    uint8_t  rsv[0xA0 - 0x2C];
+    uint8_t  vendor[0x100 - 0xA0];
+    AhciPort ports[32];
+} AhciHba;
+
+typedef struct {
+    uint16_t flags;   // [4:0] CFL, [6] W(쓰기)
+    uint16_t prdtl;
+    volatile uint32_t prdbc;
+    uint32_t ctba, ctbau;
+    uint32_t rsv[4];
+} AhciCmdHeader;
+
+typedef struct {
+    uint32_t dba, dbau, rsv;
+    uint32_t dbc;     // [21:0] 바이트 수 - 1
+} AhciPrd;
+
+typedef struct {
+    uint8_t cfis[64];
+    uint8_t acmd[16];
+    uint8_t rsv[48];
+    AhciPrd prdt[AHCI_PRDT_ENTRIES];
+} AhciCmdTable;
+
+static AhciCmdHeader ahci_cmd_list[AHCI_MAX_SLOTS] __attribute__((aligned(1024)));
+static uint8_t ahci_fis_area[256] __attribute__((aligned(256)));
+static AhciCmdTable ahci_cmd_tables[AHCI_MAX_SLOTS] __attribute__((aligned(128)));
+static uint8_t ahci_bounce[AHCI_BOUNCE_SECTORS * 512] __attribute__((aligned(16)));
+
+static AhciHba* ahci_hba = NULL;
+static AhciPort* ahci_port = NULL;
+static bool ahci_ncq = false;
+static uint32_t ahci_depth = 1;
+static uint32_t ahci_busy = 0;                     // 처리 중인 슬롯 비트
+static BlockRequest* ahci_reqs[AHCI_MAX_SLOTS];
+
+// 명령 엔진 정지 / 시작
+static void ahci_port_stop(AhciPort* port) {
+    port->cmd &= ~AHCI_PxCMD_ST;
+    for (int i = 0; i < AHCI_TIMEOUT && (port->cmd & AHCI_PxCMD_CR); i++);
+    port->cmd &= ~AHCI_PxCMD_FRE;
+    for (int i = 0; i < AHCI_TIMEOUT && (port->cmd & AHCI_PxCMD_FR); i++);
+}
+
+static void ahci_port_start(AhciPort* port) {
+    for (int i = 0; i < AHCI_TIMEOUT && (port->cmd & AHCI_PxCMD_CR); i++);
+    port->cmd |= AHCI_PxCMD_FRE;
+    port->cmd |= AHCI_PxCMD_ST;
+}
+
+// 명령 슬롯 구성: PRDT 를 4MB 단위로 나누고 H2D 레지스터 FIS 작성
+static void ahci_fill(uint32_t slot, uint8_t command, uint64_t lba, uint32_t count,
+                      uint8_t* buf, uint32_t bytes, bool write, bool ncq) {
+    AhciCmdHeader* h = &ahci_cmd_list[slot];
+    AhciCmdTable* t = &ahci_cmd_tables[slot];
+    memset(t->cfis, 0, sizeof(t->cfis));
+
+    uint32_t prds = 0;
+    uintptr_t addr = (uintptr_t)buf;
+    while (bytes && prds < AHCI_PRDT_ENTRIES) {
+        uint32_t chunk = bytes < AHCI_PRD_MAX_BYTES ? bytes : AHCI_PRD_MAX_BYTES;
+        t->prdt[prds].dba = (uint32_t)addr;
+        t->prdt[prds].dbau = 0;
+        t->prdt[prds].rsv = 0;
+        t->prdt[prds].dbc = chunk - 1;
+        addr += chunk;
+        bytes -= chunk;
+        prds++;
+    }
+    h->flags = 5 | (write ? (1 << 6) : 0);  // FIS 길이 5 dword
+    h->prdtl = (uint16_t)prds;
+    h->prdbc = 0;
+
+    uint8_t* fis = t->cfis;
+    fis[0] = FIS_TYPE_REG_H2D;
+    fis[1] = 0x80;                     // 명령 레지스터 갱신
+    fis[2] = command;
+    fis[4] = (uint8_t)lba;
+    fis[5] = (uint8_t)(lba >> 8);
+    fis[6] = (uint8_t)(lba >> 16);
+    fis[7] = command == AHCI_CMD_IDENTIFY ? 0 : 0x40;  // LBA 모드
+    fis[8] = (uint8_t)(lba >> 24);
+    fis[9] = (uint8_t)(lba >> 32);
+    fis[10] = (uint8_t)(lba >> 40);
+    if (ncq) {
+        // NCQ: 섹터 수는 feature 필드, 태그는 count[7:3]
+        fis[3] = (uint8_t)count;
+        fis[11] = (uint8_t)(count >> 8);
+        fis[12] = (uint8_t)(slot << 3);
+    } else {
+        fis[12] = (uint8_t)count;
+        fis[13] = (uint8_t)(count >> 8);
+    }
+}
+
+static void ahci_issue(uint32_t slot, bool ncq) {
+    __asm__ volatile ("" : : : "memory");
+    if (ncq) ahci_port->sact = 1u << slot;   // SACT 를 먼저
+    ahci_port->ci = 1u << slot;
+}
+
+// 오류 후 포트 복구: 엔진 재시작, 드라이브가 계속 바쁘면 COMRESET
+static void ahci_port_recover() {
+    ahci_port_stop(ahci_port);
+    ahci_port->serr = 0xFFFFFFFF;
+    ahci_port->is = 0xFFFFFFFF;
+    if (ahci_port->tfd & (AHCI_PxTFD_BSY | AHCI_PxTFD_DRQ)) {
+        ahci_port->sctl = (ahci_port->sctl & ~0xFu) | 1;
+        for (volatile int i = 0; i < 100000; i++);
+        ahci_port->sctl &= ~0xFu;
+        for (int i = 0; i < AHCI_TIMEOUT && (ahci_port->ssts & 0xF) != 3; i++);
+        ahci_port->serr = 0xFFFFFFFF;
+    }
+    ahci_port_start(ahci_port);
+}
+
+// 끝난 슬롯 완료 처리 (NCQ 는 SACT, 일반 명령은 CI 비트가 내려가면 완료)
+static void ahci_poll() {
+    if (!ahci_busy) return;
+    uint32_t is = ahci_port->is;
+    ahci_port->is = is;
+    if (is & AHCI_PxIS_TFES) {
+        vga_write("[AHCI] I/O error.\n");
+        for (uint32_t s = 0; s < AHCI_MAX_SLOTS; s++) {
+            if (ahci_busy & (1u << s)) {
+                ahci_reqs[s]->error = true;
+                ahci_reqs[s]->done = true;
+            }
+        }
+        ahci_busy = 0;
+        ahci_port_recover();
+        return;
+    }
+    uint32_t finished = ahci_busy & ~(ahci_port->sact | ahci_port->ci);
+    while (finished) {
+        uint32_t s = __builtin_ctz(finished);
+        finished &= finished - 1;
+        ahci_busy &= ~(1u << s);
+        ahci_reqs[s]->done = true;
+    }
+}
+
+// 슬롯 하나로 동기 실행 (IDENTIFY, 바운스 버퍼 전송)
+static bool ahci_run_sync(uint8_t command, uint64_t lba, uint32_t count, uint8_t* buf, uint32_t bytes, bool write) {
+    while (ahci_busy) ahci_poll();
+    ahci_fill(0, command, lba, count, buf, bytes, write, false);
+    ahci_issue(0, false);
+    for (int i = 0; i < AHCI_TIMEOUT; i++) {
+        if (ahci_port->is & AHCI_PxIS_TFES) break;
+        if (!(ahci_port->ci & 1)) return true;
+    }
+    ahci_port_recover();
+    return false;
+}
+
+// DMA 주소는 2바이트 정렬이어야 하므로 홀수 주소 버퍼는 바운스 버퍼로 나눠 전송
+static bool ahci_bounce_rw(BlockRequest* req) {
+    uint64_t lba = req->lba;
+    uint32_t left = req->count;
+    uint8_t* buf = req->buf;
+    uint8_t command = req->write ? ATA_CMD_WRITE_DMA_EXT : ATA_CMD_READ_DMA_EXT;
+    while (left) {
+        uint32_t c = left < AHCI_BOUNCE_SECTORS ? left : AHCI_BOUNCE_SECTORS;
+        if (req->write) memcpy(ahci_bounce, buf, c * 512);
+        if (!ahci_run_sync(command, lba, c, ahci_bounce, c * 512, req->write)) return false;
+        if (!req->write) memcpy(buf, ahci_bounce, c * 512);
+        lba += c;
+        buf += c * 512;
+        left -= c;
+    }
+    return true;
+}
+
+static bool ahci_submit(BlockRequest* req) {
+    if ((uintptr_t)req->buf & 1) {
+        req->error = !ahci_bounce_rw(req);
+        req->done = true;
+        return true;
+    }
+    uint32_t free_slots = ~ahci_busy & (ahci_depth == 32 ? 0xFFFFFFFFu : ((1u << ahci_depth) - 1));
+    if (!free_slots) return false;
+    uint32_t slot = __builtin_ctz(free_slots);
+
+    uint8_t command;
+    if (ahci_ncq) command = req->write ? ATA_CMD_WRITE_FPDMA_QUEUED : ATA_CMD_READ_FPDMA_QUEUED;
+    else command = req->write ? ATA_CMD_WRITE_DMA_EXT : ATA_CMD_READ_DMA_EXT;
+    ahci_fill(slot, command, req->lba, req->count, req->buf, req->count * 512, req->write, ahci_ncq);
+    ahci_reqs[slot] = req;
+    ahci_busy |= 1u << slot;
+    ahci_issue(slot, ahci_ncq);
+    return true;
+}
+
+static BlockDevice ahci_block = { "ahci", 0, AHCI_MAX_SECTORS, 1, ahci_submit, ahci_poll, NULL };
+
+// 약 1us 지연 (POST 코드 포트 쓰기)
+static void ahci_delay(uint32_t us) {
+    while (us--) outb(0x80, 0);
+}
+
+// BIOS 에게서 컨트롤러 소유권을 넘겨받음 (BIOS/OS handoff 지원 HBA 만)
+static void ahci_take_ownership() {
+    if (!(ahci_hba->cap2 & AHCI_CAP2_BOH)) return;
+    ahci_hba->bohc |= AHCI_BOHC_OOS;
+    for (int i = 0; i < AHCI_TIMEOUT && (ahci_hba->bohc & AHCI_BOHC_BOS); i++);
+    // BIOS 가 진행 중인 명령을 마무리하는 중이면 최대 2초 더 대기
+    ahci_delay(25000);
+    for (int i = 0; i < 2000 && (ahci_hba->bohc & AHCI_BOHC_BB); i++) ahci_delay(1000);
+}
+
+// HBA 리셋 후 AHCI 모드로, 각 포트를 켜고 링크가 올라오기를 잠시 기다림
+static bool ahci_reset() {
+    ahci_hba->ghc |= AHCI_GHC_HR;
+    int i = 0;
+    while (i < 1000 && (ahci_hba->ghc & AHCI_GHC_HR)) { ahci_delay(1000); i++; }
+    if (ahci_hba->ghc & AHCI_GHC_HR) return false;
+    ahci_hba->ghc |= AHCI_GHC_AE;
+    ahci_hba->ghc &= ~AHCI_GHC_IE;   // 폴링 방식
+
+    uint32_t pi = ahci_hba->pi;
+    if (ahci_hba->cap & AHCI_CAP_SSS) {
+        for (int p = 0; p < 32; p++) {
+            if (pi & (1u << p)) ahci_hba->ports[p].cmd |= AHCI_PxCMD_SUD;
+        }
+    }
+    for (int t = 0; t < AHCI_LINK_WAIT; t++) {
+        bool waiting = false;
+        for (int p = 0; p < 32; p++) {
+            if ((pi & (1u << p)) && (ahci_hba->ports[p].ssts & 0xF) != 3) waiting = true;
+        }
+        if (!waiting) break;
+        ahci_delay(1);
+    }
+    return true;
+}
+
+// 장치가 처음 보내는 레지스터 FIS (서명) 가 올 때까지 대기
+static void ahci_wait_ready(AhciPort* port) {
+    for (int i = 0; i < AHCI_LINK_WAIT && (port->tfd & (AHCI_PxTFD_BSY | AHCI_PxTFD_DRQ)); i++) ahci_delay(100);
+}
+
+// 컨트롤러/포트 초기화 후 IDENTIFY 로 용량·NCQ 깊이 확인, 블록 장치로 등록
+static bool ahci_init() {
+    PciLocation loc;
+    if (!pci_find(0xFFFF, 0xFFFF, 0x01, 0x06, 0x01, &loc)) return false;
+    pci_enable(loc);
+    ahci_hba = (AhciHba*)(uintptr_t)(pci_read32(loc, PCI_BAR5) & 0xFFFFFFF0);
+
+    ahci_hba->ghc |= AHCI_GHC_AE;
+    ahci_take_ownership();
+    if (!ahci_reset()) {
+        vga_write("[AHCI] HBA reset timed out.\n");
+        return false;
+    }
+
+    uint32_t pi = ahci_hba->pi;
+    ahci_port = NULL;
+    for (int i = 0; i < 32; i++) {
+        if (!(pi & (1u << i))) continue;
+        AhciPort* port = &ahci_hba->ports[i];
+        uint32_t ssts = port->ssts;
+        if ((ssts & 0xF) == 3) ahci_wait_ready(port);
+        // DET=3 (장치 연결, 통신 중), IPM=1 (active), ATA 서명
+        if ((ssts & 0xF) == 3 && ((ssts >> 8) & 0xF) == 1 && port->sig == AHCI_SIG_ATA) {
+            ahci_port = port;
+            break;
+        }
+    }
+    if (!ahci_port) return false;
+
+    ahci_port_stop(ahci_port);
+    memset(ahci_cmd_list, 0, sizeof(ahci_cmd_list));
+    memset(ahci_fis_area, 0, sizeof(ahci_fis_area));
+    for (int s = 0; s < AHCI_MAX_SLOTS; s++) {
+        ahci_cmd_list[s].ctba = (uint32_t)(uintptr_t)&ahci_cmd_tables[s];
+        ahci_cmd_list[s].ctbau = 0;
+    }
+    ahci_port->clb = (uint32_t)(uintptr_t)ahci_cmd_list;
+    ahci_port->clbu = 0;
+    ahci_port->fb = (uint32_t)(uintptr_t)ahci_fis_area;
+    ahci_port->fbu = 0;
+    ahci_port->serr = 0xFFFFFFFF;
+    ahci_port->is = 0xFFFFFFFF;
+    ahci_port->ie = 0;
+    ahci_port_start(ahci_port);
+
+    static uint16_t id[256] __attribute__((aligned(16)));
+    if (!ahci_run_sync(AHCI_CMD_IDENTIFY, 0, 0, (uint8_t*)id, 512, false)) return false;
+
+    uint32_t cap = ahci_hba->cap;
+    uint32_t slots = ((cap >> 8) & 0x1F) + 1;
+    ahci_ncq = (cap & AHCI_CAP_SNCQ) && (id[76] & (1 << 8));
+    ahci_depth = slots;
+    if (ahci_ncq && (uint32_t)(id[75] & 0x1F) + 1 < ahci_depth) ahci_depth = (id[75] & 0x1F) + 1;
+
+    if ((id[83] >> 10) & 1) {
+        ahci_block.sectors = (uint64_t)id[100] | ((uint64_t)id[101] << 16) |
+                             ((uint64_t)id[102] << 32) | ((uint64_t)id[103] << 48);
+    } else {
+        ahci_block.sectors = (uint32_t)id[60] | ((uint32_t)id[61] << 16);
+    }
+    ahci_block.queue_depth = ahci_depth;
+    block_dev = &ahci_block;
+
+    vga_write(ahci_ncq ? "[AHCI] SATA disk, NCQ enabled\n" : "[AHCI] SATA disk, NCQ unavailable\n");
+    return true;
+}
+
+#endif // NEUIX_AHCI_H
@@ -3,7 +3,9 @@
 
 #include "io.h"
 #include <stdint.h>
+#include <stdbool.h>
 #include "neuix_vga.h"
+#include "neuix_block.h"
 
 // ATA 포트 정의
 #define ATA_DATA_PORT       0x1F0
@@ -17,8 +19,11 @@
 #define ATA_STATUS_PORT     0x1F7
 
 // ATA 명령어
-#define ATA_CMD_READ_SECTORS    0x20
-#define ATA_CMD_WRITE_SECTORS   0x30
+#define ATA_CMD_READ_SECTORS        0x20
+#define ATA_CMD_READ_SECTORS_EXT    0x24
+#define ATA_CMD_WRITE_SECTORS       0x30
+#define ATA_CMD_WRITE_SECTORS_EXT   0x34
+#define ATA_CMD_IDENTIFY            0xEC
 
 // 상태 비트
 #define ATA_STATUS_ERR  (1 << 0)
@@ -43,53 +48,132 @@ static bool ata_wait_drq() {
     return true;
 }
 
-// 하나의 섹터 읽기 (512바이트)
-static bool ata_read_sector(uint32_t lba, uint8_t* buffer) {
+// IDENTIFY 결과
+static bool ata_present = false;
+static bool ata_lba48 = false;
+static uint64_t ata_sectors = 0;   // 디스크 전체 섹터 수
+
+// IDENTIFY DEVICE 로 LBA48 지원 여부와 용량 확인
+static bool ata_identify() {
+    outb(ATA_DRIVE_SELECT, 0xA0);  // master
+    outb(ATA_SECTOR_COUNT, 0);
+    outb(ATA_LBA_LOW, 0);
+    outb(ATA_LBA_MID, 0);
+    outb(ATA_LBA_HIGH, 0);
+    outb(ATA_COMMAND_PORT, ATA_CMD_IDENTIFY);
+
+    if (inb(ATA_STATUS_PORT) == 0) return false;  // 드라이브 없음
     ata_wait();
+    if (inb(ATA_LBA_MID) || inb(ATA_LBA_HIGH)) return false;  // ATAPI/SATA 등 ATA 아님
+    if (!ata_wait_drq()) return false;
+
+    uint16_t id[256];
+    for (int i = 0; i < 256; i++) id[i] = inw(ATA_DATA_PORT);
+
+    ata_present = true;
+    ata_lba48 = (id[83] >> 10) & 1;
+    if (ata_lba48) {
+        ata_sectors = (uint64_t)id[100] | ((uint64_t)id[101] << 16) |
+                      ((uint64_t)id[102] << 32) | ((uint64_t)id[103] << 48);
+    } else {
+        ata_sectors = (uint32_t)id[60] | ((uint32_t)id[61] << 16);
+    }
+    return true;
+}
 
-    outb(ATA_DRIVE_SELECT, 0xE0 | ((lba >> 24) & 0x0F));  // master, LBA
-    outb(ATA_SECTOR_COUNT, 1);                            // 1 sector
+// 주소/개수 설정 후 명령 전송 (28비트로 표현 가능하면 LBA28, 아니면 LBA48 EXT)
+static bool ata_issue(uint64_t lba, uint32_t count, uint8_t cmd28, uint8_t cmd48) {
+    ata_wait();
+    if (lba + count <= 0x0FFFFFFF && count <= 256) {
+        outb(ATA_DRIVE_SELECT, 0xE0 | ((lba >> 24) & 0x0F));  // master, LBA
+        outb(ATA_SECTOR_COUNT, (uint8_t)count);               // 0 = 256
+        outb(ATA_LBA_LOW,  (uint8_t)(lba & 0xFF));
+        outb(ATA_LBA_MID,  (uint8_t)((lba >> 8) & 0xFF));
+        outb(ATA_LBA_HIGH, (uint8_t)((lba >> 16) & 0xFF));
+        outb(ATA_COMMAND_PORT, cmd28);
+        return true;
+    }
+    if (!ata_lba48 || count > 65536) return false;
+    outb(ATA_DRIVE_SELECT, 0x40);  // master, LBA
+    // 상위 바이트 먼저, 그다음 하위 바이트
+    outb(ATA_SECTOR_COUNT, (uint8_t)(count >> 8));
+    outb(ATA_LBA_LOW,  (uint8_t)((lba >> 24) & 0xFF));
+    outb(ATA_LBA_MID,  (uint8_t)((lba >> 32) & 0xFF));
+    outb(ATA_LBA_HIGH, (uint8_t)((lba >> 40) & 0xFF));
+    outb(ATA_SECTOR_COUNT, (uint8_t)count);  // 0 = 65536
     outb(ATA_LBA_LOW,  (uint8_t)(lba & 0xFF));
     outb(ATA_LBA_MID,  (uint8_t)((lba >> 8) & 0xFF));
     outb(ATA_LBA_HIGH, (uint8_t)((lba >> 16) & 0xFF));
-    outb(ATA_COMMAND_PORT, ATA_CMD_READ_SECTORS);
+    outb(ATA_COMMAND_PORT, cmd48);
+    return true;
+}
 
-    if (!ata_wait_drq()) {
-        vga_write("[ATA] Read error.\n");
+// 연속 섹터 읽기 (count: 1 ~ 256)
+static bool ata_read_sectors(uint64_t lba, uint32_t count, uint8_t* buffer) {
+    if (!ata_issue(lba, count, ATA_CMD_READ_SECTORS, ATA_CMD_READ_SECTORS_EXT)) {
+        vga_write("[ATA] LBA out of range.\n");
         return false;
     }
-
-    for (int i = 0; i < 256; i++) {  // 256 words = 512 bytes
-        uint16_t data = inw(ATA_DATA_PORT);
-        buffer[i * 2 + 0] = (uint8_t)(data & 0xFF);
-        buffer[i * 2 + 1] = (uint8_t)(data >> 8);
+    for (uint32_t s = 0; s < count; s++) {
+        ata_wait();
+        if (!ata_wait_drq()) {
+            vga_write("[ATA] Read error.\n");
+            return false;
+        }
+        for (int i = 0; i < 256; i++) {  // 256 words = 512 bytes
+            uint16_t data = inw(ATA_DATA_PORT);
+            buffer[i * 2 + 0] = (uint8_t)(data & 0xFF);
+            buffer[i * 2 + 1] = (uint8_t)(data >> 8);
+        }
+        buffer += 512;
     }
-
     return true;
 }
 
-// 하나의 섹터 쓰기 (512바이트)
-static bool ata_write_sector(uint32_t lba, const uint8_t* buffer) {
-    ata_wait();
-
-    outb(ATA_DRIVE_SELECT, 0xE0 | ((lba >> 24) & 0x0F));  // master, LBA
-    outb(ATA_SECTOR_COUNT, 1);
-    outb(ATA_LBA_LOW,  (uint8_t)(lba & 0xFF));
-    outb(ATA_LBA_MID,  (uint8_t)((lba >> 8) & 0xFF));
-    outb(ATA_LBA_HIGH, (uint8_t)((lba >> 16) & 0xFF));
-    outb(ATA_COMMAND_PORT, ATA_CMD_WRITE_SECTORS);
-
-    if (!ata_wait_drq()) {
-        vga_write("[ATA] Write error.\n");
+// 연속 섹터 쓰기 (count: 1 ~ 256)
+static bool ata_write_sectors(uint64_t lba, uint32_t count, const uint8_t* buffer) {
+    if (!ata_issue(lba, count, ATA_CMD_WRITE_SECTORS, ATA_CMD_WRITE_SECTORS_EXT)) {
+        vga_write("[ATA] LBA out of range.\n");
         return false;
     }
-
-    for (int i = 0; i < 256; i++) {
-        uint16_t data = (uint16_t)buffer[i * 2] | ((uint16_t)buffer[i * 2 + 1] << 8);
-        outw(ATA_DATA_PORT, data);
+    for (uint32_t s = 0; s < count; s++) {
+        ata_wait();
+        if (!ata_wait_drq()) {
+            vga_write("[ATA] Write error.\n");
+            return false;
+        }
+        for (int i = 0; i < 256; i++) {
+            uint16_t data = (uint16_t)buffer[i * 2] | ((uint16_t)buffer[i * 2 + 1] << 8);
+            outw(ATA_DATA_PORT, data);
+        }
+        buffer += 512;
     }
+    return true;
+}
 
+// ---- 블록 장치 (PIO 는 동기식: submit 에서 바로 완료) ----
+
+static bool ata_block_submit(BlockRequest* req) {
+    uint16_t ev = req->write ? TRACE_EV_ATA_WRITE : TRACE_EV_ATA_READ;
+    TRACE_BEGIN(TRACE_CAT_BLOCK, ev, req->count);
+    bool ok = req->write ? ata_write_sectors(req->lba, req->count, req->buf)
+                         : ata_read_sectors(req->lba, req->count, req->buf);
+    TRACE_END(TRACE_CAT_BLOCK, ev, ok);
+    req->error = !ok;
+    req->done = true;
     return true;
 }
 
+static void ata_block_poll() {}
+
+static BlockDevice ata_block = { "ata-pio", 0, 256, 1, ata_block_submit, ata_block_poll, NULL };
+
+// IDENTIFY 에 실패해도 (용량 0 으로) 등록: 예전처럼 PIO 로 접근 시도
+static bool ata_init() {
+    bool found = ata_identify();
+    ata_block.sectors = ata_sectors;
+    block_dev = &ata_block;
+    return found;
+}
+
 #endif // NEUIX_ATA_H
@@ -0,0 +1,101 @@
+// neuix_block.h – 블록 장치 인터페이스 (파일시스템 ↔ 디스크 드라이버)
+//
+// 드라이버는 BlockDevice 를 채워 block_dev 에 등록한다.
+// submit 은 요청을 큐에 넣고(가득 차면 false), poll 은 끝난 요청에 done 을 표시한다.
+// 알림을 모아 보내는 드라이버(virtio)는 flush 에서 장치에 알리고, 제출하는 쪽은
+// 한 묶음을 넣은 뒤 block_flush 를 부른다. 동기식 드라이버(ATA PIO)는 submit 안에서
+// 바로 끝내도 된다.
+
+#ifndef NEUIX_BLOCK_H
+#define NEUIX_BLOCK_H
+
+#include "neuix_trace.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BLOCK_SECTOR_SIZE 512
+#define BLOCK_BATCH 32   // 한 번에 띄우는 최대 요청 수 (장치 큐가 더 얕으면 그만큼)
+
+typedef struct {
+    uint64_t lba;
+    uint32_t count;       // 섹터 수 (<= max_sectors)
+    uint8_t* buf;
+    bool write;
+    volatile bool done;
+    bool error;
+} BlockRequest;
+
+typedef struct {
+    const char* name;
+    uint64_t sectors;      // 전체 섹터 수 (0 이면 알 수 없음)
+    uint32_t max_sectors;  // 요청 하나의 최대 섹터 수
+    uint32_t queue_depth;  // 동시에 처리 가능한 요청 수
+    bool (*submit)(BlockRequest* req);
+    void (*poll)(void);
+    void (*flush)(void);   // 제출한 요청을 장치에 알림 (NULL 이면 submit 이 바로 알림)
+} BlockDevice;
+
+static BlockDevice* block_dev = NULL;
+
+// 제출 묶음의 끝: 쌓인 요청을 장치로 보냄
+static void block_flush() {
+    if (block_dev->flush) block_dev->flush();
+}
+
+static bool block_wait(BlockRequest* req) {
+    block_flush();
+    while (!req->done) block_dev->poll();
+    return !req->error;
+}
+
+// 큐가 비면 들어갈 때까지 poll 하며 제출 (큐에 든 요청이 알림 전이면 먼저 알림)
+static void block_submit(BlockRequest* req) {
+    req->done = false;
+    req->error = false;
+    while (!block_dev->submit(req)) {
+        block_flush();
+        block_dev->poll();
+    }
+}
+
+// 한 묶음으로 띄울 요청 수: 장치 큐 깊이와 BLOCK_BATCH 중 작은 쪽
+static uint32_t block_batch() {
+    uint32_t depth = block_dev->queue_depth;
+    return depth && depth < BLOCK_BATCH ? depth : BLOCK_BATCH;
+}
+
+// 큰 전송은 max_sectors 단위로 나눠 한 묶음씩 동시에 띄움
+static bool block_transfer(uint64_t lba, uint32_t count, uint8_t* buf, bool write) {
+    BlockRequest reqs[BLOCK_BATCH];
+    uint32_t batch = block_batch();
+    bool ok = true;
+    uint16_t ev = write ? TRACE_EV_BLOCK_WRITE : TRACE_EV_BLOCK_READ;
+    TRACE_BEGIN(TRACE_CAT_BLOCK, ev, count);
+    while (count) {
+        uint32_t n = 0;
+        while (count && n < batch) {
+            uint32_t c = count < block_dev->max_sectors ? count : block_dev->max_sectors;
+            BlockRequest* r = &reqs[n++];
+            r->lba = lba;
+            r->count = c;
+            r->buf = buf;
+            r->write = write;
+            block_submit(r);
+            lba += c;
+            buf += c * BLOCK_SECTOR_SIZE;
+            count -= c;
+        }
+        block_flush();
+        for (uint32_t i = 0; i < n; i++) {
+            if (!block_wait(&reqs[i])) ok = false;
+        }
+    }
+    TRACE_END(TRACE_CAT_BLOCK, ev, ok);
+    return ok;
+}
+
+static bool block_read(uint64_t lba, uint32_t count, uint8_t* buf) {
+    return block_transfer(lba, count, buf, false);
+}
+
+#endif // NEUIX_BLOCK_H
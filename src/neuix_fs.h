@@ -1,13 +1,27 @@
 #ifndef NEUIX_FS_H
 #define NEUIX_FS_H
 
+#include "neuix_block.h"
 #include "neuix_ata.h"
+#include "neuix_ahci.h"
+#include "neuix_virtio_blk.h"
+#include "neuix_readahead.h"
+#include "neuix_path.h"
+#include "neuix_trace.h"
 #include "neuix_vga.h"
+#include "neuix_mem.h"
 #include <stdint.h>
 #include <stdbool.h>
 
-#define FS_DISK_START_LBA 1
-#define FS_MAX_DISK_SECTORS 4096
+// 디스크 배치: LBA 1 = 슈퍼블록, LBA 2 부터 레코드 이미지
+// (슈퍼블록이 없는 옛 디스크는 LBA 1 부터 이미지, 최대 4096 섹터)
+#define FS_SUPERBLOCK_LBA  1
+#define FS_IMAGE_START_LBA 2
+#define FS_LEGACY_SECTORS  4096
+#define FS_MAGIC           "NEUIXFS2"
+
+#define FS_POS_NONE 0xFFFFFFFFFFFFFFFFull
+#define FS_REF_NONE 0xFFFFFFFF
 
 typedef enum {
     TYPE_FILE,
@@ -15,27 +29,98 @@ typedef enum {
     TYPE_BINARY
 } FileType;
 
+// 파일 내용: data 가 있으면 메모리가 기준, 없으면 디스크 (또는 빈 내용).
+// 부팅 때는 디스크 위치만 기억하고, 쓰기나 위치 이동이 필요할 때 메모리로 올린다.
+// 노드 안의 내용이 디스크에 있을 때 capacity 는 레코드 머리말 길이라서
+// 위치는 disk_pos 에서 계산한다 (fs_node_disk_off).
+typedef struct {
+    uint8_t* data;
+    uint32_t capacity;
+} FileContent;
+
+// cp 로 공유된 내용 (참조 카운트). 공유하지 않는 파일은 내용을 노드 안에 둔다
+typedef struct FileExtent {
+    FileContent c;
+    uint64_t disk_off;  // 내용을 기록한 레코드의 내용 위치 (LBA 0 기준 바이트, c.data 가 없을 때)
+    uint32_t refcount;
+    uint32_t disk_id;   // 내용을 기록한 레코드 번호 (저장 시 공유 식별)
+    uint32_t save_gen;  // 현재 fs_save 에서 이미 기록했는지 여부
+} FileExtent;
+
+// 목록 순회에 쓰는 필드를 앞쪽에 모음 (i386 에서 32바이트, 경로는 neuix_path.h 의 ID)
 typedef struct FileNode {
-    char path[256];
-    FileType type;
-    uint8_t* content;
-    uint32_t size;
     struct FileNode* next;
+    uint32_t size;
+    uint32_t path_id;
+    uint8_t type;        // FileType
+    bool dirty;          // 마지막 저장 이후 경로/내용 변경
+    uint8_t mount;       // 속한 마운트 (fs_mounts 번호)
+    bool shared;         // 내용이 share.extent 에 있음
+    union {
+        FileContent own;
+        struct {
+            FileExtent* extent;
+            uint32_t disk_ref;   // 마지막 저장 때 "&n" 참조 번호 (없으면 FS_REF_NONE)
+        } share;
+    };
+    uint64_t disk_pos;   // 마지막 저장 때 레코드 위치 (이미지 내 바이트)
 } FileNode;
 
+#define FS_NODE_BLOCK 128   // 노드는 이만큼씩 한 번에 할당 (malloc 헤더 없이 연속 배치)
+
+typedef struct {
+    char magic[8];
+    uint64_t image_len;   // 끝 표시(0) 포함 이미지 바이트 수
+    uint8_t reserved[512 - 16];
+} __attribute__((packed)) FsSuperblock;
+
+// ---- 마운트 테이블 ----
+// 0 번은 디스크 ("/", 노드 목록은 fs_root). tmpfs 는 노드를 메모리에만 두고
+// 저장(fs_save)도 블록 장치도 건드리지 않는다. 경로는 가장 가까운 마운트 지점이 맡는다.
+
+#define FS_MAX_MOUNTS        8
+#define FS_MOUNT_DISK        0
+#define FS_TMPFS_DEFAULT_MAX (1024 * 1024)
+
+typedef enum {
+    MOUNT_DISK,
+    MOUNT_TMPFS
+} MountType;
+
+typedef struct {
+    uint32_t path_id;   // 마운트 지점 (PATH_NONE = 빈 슬롯)
+    MountType type;
+    FileNode* nodes;    // tmpfs 노드 목록
+    uint32_t limit;     // tmpfs 바이트 한도 (0 = 무제한)
+    uint32_t used;      // 파일 크기 합
+} FsMount;
+
 static FileNode* fs_root = NULL;
-static uint8_t fs_disk_cache[512 * FS_MAX_DISK_SECTORS];
+static FsMount fs_mounts[FS_MAX_MOUNTS] = { { PATH_ROOT, MOUNT_DISK, NULL, 0, 0 } };
+static uint32_t fs_mount_count = 1;
+static FileNode* fs_node_free_list = NULL;
+static uint32_t fs_node_blocks = 0;
+static uint32_t fs_save_gen = 0;
+static uint64_t fs_volume_sectors = FS_LEGACY_SECTORS;  // 이미지 영역 섹터 수 (IDENTIFY 로 갱신)
+static uint64_t fs_image_len = 0;                       // 디스크 슈퍼블록에 기록된 값
 
-static int strlen(const char* s) { int i = 0; while (s[i]) i++; return i; }
-static void strcpy(char* dst, const char* src) { while (*src) *dst++ = *src++; *dst = 0; }
-static bool streq(const char* a, const char* b) {
-    while (*a && *b) { if (*a != *b) return false; a++; b++; }
-    return *a == *b;
+static FileNode* fs_node_alloc() {
+    if (!fs_node_free_list) {
+        FileNode* block = (FileNode*) malloc(FS_NODE_BLOCK * sizeof(FileNode));
+        for (uint32_t i = 0; i < FS_NODE_BLOCK; i++) {
+            block[i].next = fs_node_free_list;
+            fs_node_free_list = &block[i];
+        }
+        fs_node_blocks++;
+    }
+    FileNode* node = fs_node_free_list;
+    fs_node_free_list = node->next;
+    return node;
 }
-static void strcat(char* dst, const char* src) {
-    while (*dst) dst++;
-    while (*src) *dst++ = *src++;
-    *dst = 0;
+
+static void fs_node_release(FileNode* node) {
+    node->next = fs_node_free_list;
+    fs_node_free_list = node;
 }
 
 static FileType parse_type(const char* s) {
@@ -53,223 +138,1129 @@ static const char* type_to_str(FileType t) {
     return "file";
 }
 
-// 바이너리 실행용 타입
-typedef void (*binary_entry_t)(void);
+static void fs_content_init(FileContent* c) {
+    c->data = NULL;
+    c->capacity = 0;
+}
+
+// 메모리 내용으로 채움 (data 가 NULL 이면 0 으로)
+static void fs_content_set(FileContent* c, const uint8_t* data, uint32_t size) {
+    c->data = (uint8_t*) malloc(size);
+    if (data) memcpy(c->data, data, size);
+    else memset(c->data, 0, size);
+    c->capacity = size;
+}
+
+static void fs_content_free(FileContent* c) {
+    if (c->data) free(c->data);
+    fs_content_init(c);
+}
+
+// 내용 일부 읽기: 메모리(data), 디스크(disk_off), 둘 다 없으면 0.
+// ra 는 읽는 쪽(열린 파일)의 접근 패턴, NULL 이면 이번 한 번만의 스트림
+static void fs_content_read(const uint8_t* data, uint64_t disk_off, uint32_t size, uint32_t off,
+                            uint8_t* dst, uint32_t len, ReadaheadState* ra) {
+    if (data || disk_off == FS_POS_NONE) {
+        if (data) memcpy(dst, data + off, len);
+        else memset(dst, 0, len);
+        return;
+    }
+    ReadaheadState once;
+    if (!ra) ra = &once;
+    // 새 스트림이거나 저장으로 내용 위치가 옮겨졌으면 다시 시작
+    if (ra == &once || ra->end != disk_off + size) {
+        ra_stream_init(ra, disk_off + off, disk_off + size);
+    }
+    ra_read(ra, disk_off + off, dst, len);
+}
+
+static FileExtent* fs_extent_get(FileExtent* ext) {
+    ext->refcount++;
+    return ext;
+}
+
+// 공유 해제 (마지막 참조일 때만 메모리 반환)
+static void fs_extent_put(FileExtent* ext) {
+    if (--ext->refcount == 0) {
+        fs_content_free(&ext->c);
+        free(ext);
+    }
+}
+
+static FileContent* fs_node_content(FileNode* node) {
+    return node->shared ? &node->share.extent->c : &node->own;
+}
+
+// 디스크에만 있는 내용의 위치 (메모리에 있거나 내용이 없으면 FS_POS_NONE)
+static uint64_t fs_node_disk_off(FileNode* node) {
+    if (node->shared) {
+        FileExtent* ext = node->share.extent;
+        return ext->c.data ? FS_POS_NONE : ext->disk_off;
+    }
+    if (node->own.data || !node->own.capacity || !node->size || node->disk_pos == FS_POS_NONE) {
+        return FS_POS_NONE;
+    }
+    return (uint64_t)FS_IMAGE_START_LBA * 512 + node->disk_pos + node->own.capacity;
+}
+
+// 저장 때 이 노드 레코드가 가리킨 공유 번호
+static uint32_t fs_node_ref(FileNode* node) {
+    return node->shared ? node->share.disk_ref : FS_REF_NONE;
+}
+
+static void fs_node_read(FileNode* node, uint32_t off, uint8_t* dst, uint32_t len, ReadaheadState* ra) {
+    fs_content_read(fs_node_content(node)->data, fs_node_disk_off(node), node->size, off, dst, len, ra);
+}
+
+// 내용 전체를 메모리로 (수정하거나 디스크의 옛 위치가 덮이기 전에)
+static void fs_node_load(FileNode* node) {
+    uint64_t at = fs_node_disk_off(node);
+    FileContent* c = fs_node_content(node);
+    if (at == FS_POS_NONE) {
+        if (!c->data) c->capacity = 0;   // 머리말 길이가 남아 있으면 빈 내용으로
+        return;
+    }
+    uint8_t* data = (uint8_t*) malloc(node->size);
+    fs_content_read(NULL, at, node->size, 0, data, node->size, NULL);
+    c->data = data;
+    c->capacity = node->size;
+}
+
+// 내용 버리기 (공유 중이면 참조만 반환)
+static void fs_node_drop(FileNode* node) {
+    if (node->shared) fs_extent_put(node->share.extent);
+    else fs_content_free(&node->own);
+    node->shared = false;
+    fs_content_init(&node->own);
+}
+
+// cp 용: 노드 안의 내용을 공유 extent 로 옮기고 참조 하나를 더 얻음
+static FileExtent* fs_node_share(FileNode* node) {
+    if (!node->shared) {
+        FileExtent* ext = (FileExtent*) malloc(sizeof(FileExtent));
+        ext->disk_off = fs_node_disk_off(node);
+        ext->c = node->own;
+        if (!ext->c.data) ext->c.capacity = 0;
+        ext->refcount = 1;
+        ext->disk_id = 0;
+        ext->save_gen = 0;
+        node->shared = true;
+        node->share.extent = ext;
+        node->share.disk_ref = FS_REF_NONE;
+    }
+    return fs_extent_get(node->share.extent);
+}
 
-// 바이너리 파일 실행 함수
-typedef void (*binary_entry_t)(void);
-static void run_binary(const uint8_t* bin, uint32_t size) {
-    uint8_t* target = (uint8_t*)0x100000;
-    for (uint32_t i = 0; i < size; i++) {
-        target[i] = bin[i];
+// 공유를 끊고 내용을 노드 안으로 (혼자 남았으면 복사 없이 넘겨받음)
+static void fs_node_unshare(FileNode* node) {
+    if (!node->shared) return;
+    FileExtent* ext = node->share.extent;
+    uint64_t at = fs_node_disk_off(node);
+    // 마지막 저장에서 이 레코드가 내용을 기록했고 그 뒤 바뀌지 않았으면 내용은 자기 레코드 안
+    bool in_record = at != FS_POS_NONE && !node->dirty && node->share.disk_ref == FS_REF_NONE
+                  && node->disk_pos != FS_POS_NONE;
+    // "&n" 으로 기록된 레코드는 내용을 담아 다시 써야 함
+    if (node->share.disk_ref != FS_REF_NONE) node->dirty = true;
+    FileContent own;
+    fs_content_init(&own);
+    if (ext->refcount == 1 && (ext->c.data || at == FS_POS_NONE || in_record)) {
+        own = ext->c;
+        if (!own.data && in_record) {
+            own.capacity = (uint32_t)(at - (uint64_t)FS_IMAGE_START_LBA * 512 - node->disk_pos);
+        }
+        free(ext);
+    } else {
+        if (node->size) {
+            fs_content_set(&own, NULL, node->size);
+            fs_node_read(node, 0, own.data, node->size, NULL);
+        }
+        fs_extent_put(ext);
     }
+    node->shared = false;
+    node->own = own;
+}
 
-    extern volatile bool esc_pressed;
-    esc_pressed = false;
+// 메모리에만 있는 단독 내용으로 (다른 종류의 마운트로 옮길 때)
+static void fs_node_private(FileNode* node) {
+    fs_node_unshare(node);
+    fs_node_load(node);
+}
 
-    __asm__ volatile ("sti");
+// 경로를 맡는 마운트: 자신부터 부모 쪽으로 올라가며 마운트 지점 검색
+static uint8_t fs_mount_of(uint32_t path_id) {
+    for (uint32_t id = path_id; id != PATH_NONE; id = path_parent(id)) {
+        for (uint32_t m = 1; m < fs_mount_count; m++) {
+            if (fs_mounts[m].path_id == id) return (uint8_t)m;
+        }
+    }
+    return FS_MOUNT_DISK;
+}
 
-    binary_entry_t entry = (binary_entry_t)target;
-    entry();
+static FileNode** fs_mount_list(uint8_t m) {
+    return m == FS_MOUNT_DISK ? &fs_root : &fs_mounts[m].nodes;
+}
 
-    __asm__ volatile ("cli");
+// tmpfs 마운트 지점인지 (디스크 루트 제외)
+static bool fs_is_mount_point(uint32_t path_id) {
+    for (uint32_t m = 1; m < fs_mount_count; m++) {
+        if (fs_mounts[m].path_id == path_id) return true;
+    }
+    return false;
+}
 
-    vga_set_color(COLOR_LIGHT_GREEN, COLOR_BLACK);
-    vga_write("\n[Exited binary program]\n");
+// 바깥 마운트의 노드가 안쪽 마운트에 가려졌는지 (목록에는 남아 저장되지만 보이지 않음)
+static bool fs_node_shadowed(FileNode* node, uint8_t m) {
+    return fs_mount_of(node->path_id) != m;
+}
+
+// 메모리에 올라와 있는 파일 내용 바이트 (공유 extent 는 참조 수로 나눔)
+static uint32_t fs_resident_bytes(FileNode* list) {
+    uint32_t bytes = 0;
+    for (FileNode* node = list; node; node = node->next) {
+        FileContent* c = fs_node_content(node);
+        if (!c->data) continue;
+        bytes += node->shared ? c->capacity / node->share.extent->refcount : c->capacity;
+    }
+    return bytes;
+}
+
+// 경로 ID 로 노드 찾기
+static FileNode* fs_lookup_id(uint32_t path_id) {
+    if (path_id == PATH_NONE) return NULL;
+    for (FileNode* node = *fs_mount_list(fs_mount_of(path_id)); node; node = node->next) {
+        if (node->path_id == path_id) return node;
+    }
+    return NULL;
+}
+
+// 경로로 노드 찾기 (인터닝되지 않은 경로는 문자열 비교 없이 바로 실패)
+static FileNode* fs_lookup(const char* path) {
+    return fs_lookup_id(path_find(path));
+}
+
+// ---- 이미지 읽기 (미리 읽기 캐시를 거친 스트리밍) ----
+// 순차로 읽는 동안 창 안의 청크들이 한꺼번에 비동기 제출되고(큐 깊이만큼 동시에),
+// 건너뛴 내용도 순차로 쳐서 창을 유지한다.
+
+static uint8_t fs_rd_buf[RA_CHUNK_BYTES];
+static uint32_t fs_rd_len = 0;     // 버퍼에 든 바이트
+static uint32_t fs_rd_off = 0;
+static uint64_t fs_rd_base;        // 이미지 시작 (디스크 바이트 위치)
+static uint64_t fs_rd_pos;
+static uint64_t fs_rd_limit;
+static ReadaheadState fs_rd_ra;
+
+static int fs_rd_peek() {
+    if (fs_rd_pos >= fs_rd_limit) return 0;
+    if (fs_rd_off == fs_rd_len) {
+        // 청크 경계까지 (캐시 청크 하나만 건드림)
+        uint64_t at = fs_rd_base + fs_rd_pos;
+        uint32_t n = RA_CHUNK_BYTES - (uint32_t)(at % RA_CHUNK_BYTES);
+        if (n > fs_rd_limit - fs_rd_pos) n = (uint32_t)(fs_rd_limit - fs_rd_pos);
+        ra_read(&fs_rd_ra, at, fs_rd_buf, n);
+        fs_rd_len = n;
+        fs_rd_off = 0;
+    }
+    return fs_rd_buf[fs_rd_off];
+}
+
+static int fs_rd_getc() {
+    int c = fs_rd_peek();
+    if (fs_rd_pos < fs_rd_limit) { fs_rd_off++; fs_rd_pos++; }
+    return c;
+}
+
+// 내용 n 바이트 건너뛰기 (버퍼 밖은 읽지 않음)
+static void fs_rd_skip(uint32_t n) {
+    if (n <= fs_rd_len - fs_rd_off) {
+        fs_rd_off += n;
+        fs_rd_pos += n;
+        return;
+    }
+    fs_rd_pos += n;
+    fs_rd_off = fs_rd_len = 0;
+    ra_skip(&fs_rd_ra, fs_rd_base + fs_rd_pos);
+}
+
+// 내용 n 바이트를 dst 로 (fs_init 이 확인한 대로 이미지 안에 있어야 함)
+static void fs_rd_read(uint8_t* dst, uint32_t n) {
+    while (n && fs_rd_pos < fs_rd_limit) {
+        fs_rd_peek();
+        uint32_t k = fs_rd_len - fs_rd_off;
+        if (k > n) k = n;
+        memcpy(dst, fs_rd_buf + fs_rd_off, k);
+        fs_rd_off += k;
+        fs_rd_pos += k;
+        dst += k;
+        n -= k;
+    }
+}
+
+// 새 경로 인터닝 (너무 길면 PATH_NONE, 잘린 경로를 만들지 않음)
+static uint32_t fs_intern(const char* path) {
+    uint32_t path_id = path_intern(path);
+    if (path_id == PATH_NONE) vga_write("[FS] Path too long.\n");
+    return path_id;
+}
+
+// path 에 tmpfs 마운트 (limit 바이트까지, 0 = 무제한). 마운트 지점은 빈 디렉터리로 보임
+static bool fs_mount_tmpfs(const char* path, uint32_t limit) {
+    uint32_t path_id = fs_intern(path);
+    if (path_id == PATH_NONE || path_id == PATH_ROOT || fs_mount_count == FS_MAX_MOUNTS) return false;
+    for (uint32_t m = 0; m < fs_mount_count; m++) {
+        if (fs_mounts[m].path_id == path_id) return false;
+    }
+    // 파일이나 비어 있지 않은 디렉터리 위에는 마운트하지 않음 (그 아래 파일이 가려짐)
+    FileNode* at = fs_lookup_id(path_id);
+    if (at && at->type != TYPE_DIR) return false;
+    for (uint8_t k = 0; k < fs_mount_count; k++) {
+        for (FileNode* n = *fs_mount_list(k); n; n = n->next) {
+            for (uint32_t id = path_parent(n->path_id); id != PATH_NONE; id = path_parent(id)) {
+                if (id != path_id) continue;
+                vga_write("[FS] Mount point not empty.\n");
+                return false;
+            }
+        }
+    }
+    uint8_t m = (uint8_t)fs_mount_count++;
+    fs_mounts[m].path_id = path_id;
+    fs_mounts[m].type = MOUNT_TMPFS;
+    fs_mounts[m].limit = limit;
+    fs_mounts[m].used = 0;
+
+    FileNode* dir = fs_node_alloc();
+    dir->path_id = path_id;
+    dir->mount = m;
+    dir->type = TYPE_DIR;
+    dir->size = 0;
+    dir->shared = false;
+    fs_content_init(&dir->own);
+    dir->disk_pos = FS_POS_NONE;
+    dir->dirty = false;
+    dir->next = NULL;
+    fs_mounts[m].nodes = dir;
+    return true;
 }
 
 // 파일 시스템 초기화
 static void fs_init() {
-    for (int i = 0; i < FS_MAX_DISK_SECTORS; i++) {
-        ata_read_sector(FS_DISK_START_LBA + i, &fs_disk_cache[i * 512]);
-    }
-
-    uint8_t* p = fs_disk_cache;
-    while (*p) {
-        if (*p == '{') {
-            p++;
-            char path[256] = {0};
-            char type[16] = {0};
-            char sizebuf[16] = {0};
-            char content[4096] = {0};
-            int pi = 0, ti = 0, si = 0, ci = 0;
-
-            while (*p && *p != ':' && pi < 255) path[pi++] = *p++;
-            if (*p == ':') p++;
-            while (*p && *p != ':' && ti < 15) type[ti++] = *p++;
-            if (*p == ':') p++;
-            while (*p && *p != ':' && si < 15) sizebuf[si++] = *p++;
-            if (*p == ':') p++;
-            uint32_t size = 0;
-            for (int i = 0; i < si; i++) {
-                size = size * 10 + (sizebuf[i] - '0');
-            }
-            for (uint32_t i = 0; i < size && *p && *p != '}'; i++) {
-                content[ci++] = *p++;
-            }
-            if (*p == '}') p++;
-
-            FileNode* node = (FileNode*) malloc(sizeof(FileNode));
-            strcpy(node->path, path);
-            node->type = parse_type(type);
-            node->size = size;
-            node->content = 0;
-            if (node->type != TYPE_DIR) {
-                node->content = (uint8_t*) malloc(size);
-                for (uint32_t k = 0; k < size; k++) node->content[k] = content[k];
+    TRACE_BEGIN(TRACE_CAT_FS, TRACE_EV_FS_INIT, 0);
+    // 블록 장치 선택: virtio-blk → AHCI → ATA PIO
+    if (!virtio_blk_init() && !ahci_init()) ata_init();
+    if (block_dev->sectors > FS_IMAGE_START_LBA) {
+        fs_volume_sectors = block_dev->sectors - FS_IMAGE_START_LBA;
+    }
+
+    FsSuperblock sb;
+    block_read(FS_SUPERBLOCK_LBA, 1, (uint8_t*)&sb);
+    bool legacy = memcmp(sb.magic, FS_MAGIC, 8) != 0;
+    uint64_t image_base = (uint64_t)(legacy ? FS_SUPERBLOCK_LBA : FS_IMAGE_START_LBA) * 512;
+    if (legacy) {
+        // 옛 형식: 첫 저장 때 새 배치로 전부 다시 기록
+        fs_rd_limit = (uint64_t)FS_LEGACY_SECTORS * 512;
+        fs_image_len = 0;
+    } else {
+        fs_rd_limit = sb.image_len;
+        fs_image_len = sb.image_len;
+    }
+    fs_rd_base = image_base;
+    fs_rd_off = fs_rd_len = 0;
+    fs_rd_pos = 0;
+    ra_stream_init(&fs_rd_ra, image_base, image_base + fs_rd_limit);
+
+    uint32_t record = 0;
+    while (fs_rd_peek()) {
+        uint64_t record_pos = fs_rd_pos;
+        if (fs_rd_getc() != '{') continue;
+
+        char path[256] = {0};
+        char type[16] = {0};
+        char sizebuf[16] = {0};
+        int pi = 0, ti = 0, si = 0;
+
+        while (fs_rd_peek() && fs_rd_peek() != ':' && pi < 255) path[pi++] = fs_rd_getc();
+        if (fs_rd_peek() == ':') fs_rd_getc();
+        while (fs_rd_peek() && fs_rd_peek() != ':' && ti < 15) type[ti++] = fs_rd_getc();
+        if (fs_rd_peek() == ':') fs_rd_getc();
+        while (fs_rd_peek() && fs_rd_peek() != ':' && si < 15) sizebuf[si++] = fs_rd_getc();
+        if (fs_rd_peek() == ':') fs_rd_getc();
+        // 크기 필드: "<size>" 또는 "<size>&<n>" (n 번째 레코드의 내용을 공유)
+        uint32_t size = 0;
+        int i = 0;
+        for (; i < si && sizebuf[i] >= '0' && sizebuf[i] <= '9'; i++) {
+            size = size * 10 + (sizebuf[i] - '0');
+        }
+        char marker = (i < si) ? sizebuf[i++] : 0;
+        uint32_t ext_id = 0;
+        for (; i < si; i++) {
+            ext_id = ext_id * 10 + (sizebuf[i] - '0');
+        }
+
+        // 레코드 번호가 "&n" 참조에 쓰이므로 건너뛸 수 없음: 손상된 이미지로 보고 중단
+        uint32_t path_id = fs_intern(path);
+        if (path_id == PATH_NONE) break;
+        FileNode* node = fs_node_alloc();
+        node->path_id = path_id;
+        node->mount = FS_MOUNT_DISK;
+        node->type = parse_type(type);
+        node->shared = false;
+        fs_content_init(&node->own);
+        node->disk_pos = legacy ? FS_POS_NONE : record_pos;
+        node->dirty = false;
+        if (marker != '&' && size > fs_rd_limit - fs_rd_pos) {
+            size = (uint32_t)(fs_rd_limit - fs_rd_pos);
+        }
+        node->size = size;
+        if (node->type != TYPE_DIR) {
+            if (marker == '&') {
+                // ext_id 번째 레코드의 내용 공유 (목록 맨 앞이 직전 레코드)
+                FileNode* src = ext_id < record ? fs_root : NULL;
+                for (uint32_t k = record - 1; src && k > ext_id; k--) src = src->next;
+                if (src && src->type != TYPE_DIR) {
+                    FileExtent* ext = fs_node_share(src);
+                    node->shared = true;
+                    node->share.extent = ext;
+                    node->share.disk_ref = ext_id;
+                    node->size = src->size;
+                } else {
+                    node->size = 0;
+                    node->dirty = true;
+                }
+            } else if (legacy) {
+                // 옛 이미지는 첫 저장 때 새 위치로 옮겨지므로 지금 메모리로 (최대 2MB)
+                fs_content_set(&node->own, NULL, size);
+                fs_rd_read(node->own.data, size);
+            } else {
+                // 내용은 크기만큼 그대로 (중간에 '}' 가 있어도 됨), 읽는 건 나중에.
+                // 위치는 레코드 시작 + 머리말 길이로 기억
+                node->own.capacity = (uint32_t)(fs_rd_pos - record_pos);
+                fs_rd_skip(size);
             }
-            node->next = fs_root;
-            fs_root = node;
+        } else if (marker != '&') {
+            fs_rd_skip(size);
+        }
+        if (fs_rd_peek() == '}') fs_rd_getc();
+
+        node->next = fs_root;
+        fs_root = node;
+        record++;
+    }
+    fs_mount_tmpfs("/tmp", FS_TMPFS_DEFAULT_MAX);
+    TRACE_END(TRACE_CAT_FS, TRACE_EV_FS_INIT, record);
+}
+
+// ---- 파일 시스템 저장 ----
+// 오래된 노드부터 이어서 기록. 위치·참조가 그대로이고 바뀌지 않은 레코드는
+// 섹터 버퍼만 채우고(통째로 덮는 섹터는 건너뜀), 바뀐 바이트가 있는 섹터만 디스크에 씀.
+// 쓰기는 바로 기다리지 않는다: 이어지는 섹터는 요청 하나로 합치고, 요청들은 비동기로
+// 띄워 두었다가 fs_wr_wait 에서 한 번에 완료를 확인 (AHCI NCQ / virtio 큐를 채움).
+
+#define FS_WR_STAGE_SECTORS 128          // 섹터 버퍼 조각을 모아 두는 곳 (64KB)
+#define FS_WR_MAX_REQS      BLOCK_BATCH
+
+static uint8_t fs_wr_buf[512];
+static uint64_t fs_emit_pos = 0;
+static bool fs_wr_dirty = false;
+static bool fs_wr_overflow = false;
+
+static uint8_t fs_wr_stage[FS_WR_STAGE_SECTORS * 512] __attribute__((aligned(16)));
+static uint32_t fs_wr_staged = 0;                  // 스테이지에 채운 섹터 수
+static BlockRequest fs_wr_reqs[FS_WR_MAX_REQS];
+static uint32_t fs_wr_nreqs = 0;                   // 마지막 요청은 아직 제출 전일 수 있음
+static bool fs_wr_open = false;                    // 마지막 요청에 섹터를 더 붙일 수 있음
+static bool fs_wr_failed = false;
+
+// 더 붙일 수 없게 된 요청은 바로 장치로 (나머지 기록과 겹쳐 진행)
+static void fs_wr_submit_open() {
+    if (!fs_wr_open) return;
+    block_submit(&fs_wr_reqs[fs_wr_nreqs - 1]);
+    block_flush();
+    fs_wr_open = false;
+}
+
+// 띄운 쓰기가 모두 끝날 때까지 대기 (그 사이 미리 읽기가 옛 내용을 캐시했을 수 있으므로 다시 버림)
+static void fs_wr_wait() {
+    fs_wr_submit_open();
+    if (!fs_wr_nreqs) return;
+    TRACE_BEGIN(TRACE_CAT_BLOCK, TRACE_EV_BLOCK_WRITE, fs_wr_nreqs);
+    for (uint32_t i = 0; i < fs_wr_nreqs; i++) {
+        if (!block_wait(&fs_wr_reqs[i])) fs_wr_failed = true;
+        ra_invalidate(fs_wr_reqs[i].lba, fs_wr_reqs[i].count);
+    }
+    TRACE_END(TRACE_CAT_BLOCK, TRACE_EV_BLOCK_WRITE, !fs_wr_failed);
+    fs_wr_nreqs = 0;
+    fs_wr_staged = 0;
+}
+
+// 디스크 쓰기는 모두 여기로. buf 는 fs_wr_wait 까지 그대로 있어야 함.
+// 섹터와 메모리가 모두 바로 앞 요청에 이어지면 max_sectors 까지 그 요청을 늘림
+static void fs_disk_write(uint64_t lba, uint32_t count, const uint8_t* buf) {
+    ra_invalidate(lba, count);
+    while (count) {
+        BlockRequest* last = fs_wr_open ? &fs_wr_reqs[fs_wr_nreqs - 1] : NULL;
+        if (last && last->lba + last->count == lba && last->buf + last->count * 512 == buf) {
+            uint32_t c = block_dev->max_sectors - last->count;
+            if (c > count) c = count;
+            last->count += c;
+            lba += c;
+            buf += c * 512;
+            count -= c;
+            if (last->count == block_dev->max_sectors) fs_wr_submit_open();
+            continue;
+        }
+        fs_wr_submit_open();
+        if (fs_wr_nreqs == block_batch()) fs_wr_wait();
+        BlockRequest* r = &fs_wr_reqs[fs_wr_nreqs++];
+        r->lba = lba;
+        r->count = 0;
+        r->buf = (uint8_t*)buf;
+        r->write = true;
+        fs_wr_open = true;
+    }
+}
+
+// 섹터 버퍼 하나를 스테이지로 복사해 쓰기 요청에 추가
+static void fs_wr_flush() {
+    if (fs_wr_dirty) {
+        uint64_t sector = (fs_emit_pos - 1) / 512;
+        if (sector < fs_volume_sectors) {
+            // 새 요청이 필요한데 묶음이 찼으면 여기서 기다림 (fs_disk_write 안에서 기다리면
+            // 스테이지가 비워진 뒤에도 이 조각을 가리키는 요청이 남음)
+            uint64_t lba = FS_IMAGE_START_LBA + sector;
+            BlockRequest* last = &fs_wr_reqs[fs_wr_nreqs ? fs_wr_nreqs - 1 : 0];
+            bool joins = fs_wr_open && last->lba + last->count == lba
+                      && last->buf + last->count * 512 == fs_wr_stage + fs_wr_staged * 512
+                      && last->count < block_dev->max_sectors;
+            if (fs_wr_staged == FS_WR_STAGE_SECTORS || (!joins && fs_wr_nreqs == block_batch())) fs_wr_wait();
+            uint8_t* slot = fs_wr_stage + fs_wr_staged++ * 512;
+            memcpy(slot, fs_wr_buf, 512);
+            fs_disk_write(lba, 1, slot);
         } else {
-            p++;
+            fs_wr_overflow = true;
         }
+        fs_wr_dirty = false;
     }
 }
 
-// 파일 시스템 저장 관련
-static void fs_save() {
-    uint8_t* p = fs_disk_cache;
-    FileNode* node = fs_root;
+static void fs_emit_bytes(const uint8_t* data, uint32_t n, bool dirty) {
+    while (n) {
+        uint32_t off = (uint32_t)(fs_emit_pos % 512);
+        if (off == 0 && n >= 512) {
+            uint32_t count = n / 512;
+            if (dirty) {
+                uint64_t sector = fs_emit_pos / 512;
+                if (sector + count <= fs_volume_sectors) {
+                    fs_disk_write(FS_IMAGE_START_LBA + sector, count, data);
+                } else {
+                    fs_wr_overflow = true;
+                }
+            }
+            fs_emit_pos += count * 512;
+            data += count * 512;
+            n -= count * 512;
+            continue;
+        }
+        uint32_t chunk = 512 - off;
+        if (chunk > n) chunk = n;
+        memcpy(fs_wr_buf + off, data, chunk);
+        if (dirty) fs_wr_dirty = true;
+        fs_emit_pos += chunk;
+        data += chunk;
+        n -= chunk;
+        if (fs_emit_pos % 512 == 0) fs_wr_flush();
+    }
+}
+
+static int fs_format_num(char* out, uint32_t temp) {
+    char rev[16];
+    int ri = 0, len = 0;
+    if (temp == 0) rev[ri++] = '0';
+    while (temp) {
+        rev[ri++] = '0' + (temp % 10);
+        temp /= 10;
+    }
+    while (ri) out[len++] = rev[--ri];
+    return len;
+}
+
+// 리스트 뒤집기 (오래된 노드부터 저장 → 로드 시 순서 유지, 새 노드는 끝에 추가됨)
+static FileNode* fs_reverse(FileNode* node) {
+    FileNode* prev = NULL;
     while (node) {
-        *p++ = '{';
-        strcat((char*)p, node->path); p += strlen(node->path);
-        *p++ = ':';
-        strcat((char*)p, type_to_str(node->type)); p += strlen(type_to_str(node->type));
-        *p++ = ':';
-        char sizebuf[16] = {0};
-        int si = 0;
-        uint32_t temp = node->size;
-        char rev[16];
-        int ri = 0;
-        if (temp == 0) rev[ri++] = '0';
-        while (temp) {
-            rev[ri++] = '0' + (temp % 10);
-            temp /= 10;
+        FileNode* next = node->next;
+        node->next = prev;
+        prev = node;
+        node = next;
+    }
+    return prev;
+}
+
+// 디스크에만 있는 내용 기록: 바뀐 레코드면 메모리로 올려 그대로,
+// 아니면 통째로 덮는 섹터는 건너뛰고 걸친 섹터 조각만 디스크에서 읽어 채움.
+// 공유 내용은 새 위치를 disk_off 에 바로 적고, 메모리는 쓰기가 끝난 뒤
+// fs_spill_contents 가 반환 (그 전까지 data 는 비동기 쓰기의 원본)
+static void fs_emit_content(FileNode* node, uint32_t n, bool dirty) {
+    if (dirty) fs_node_load(node);
+    uint64_t at = fs_node_disk_off(node);
+    if (at == FS_POS_NONE) {
+        if (dirty && node->shared) {
+            node->share.extent->disk_off = (uint64_t)FS_IMAGE_START_LBA * 512 + fs_emit_pos;
+        }
+        fs_emit_bytes(fs_node_content(node)->data, n, dirty);
+        return;
+    }
+    uint8_t piece[512];
+    uint32_t off = 0;
+    while (off < n) {
+        uint32_t sec_off = (uint32_t)(fs_emit_pos % 512);
+        if (sec_off == 0 && n - off >= 512) {
+            uint32_t skip = (n - off) & ~511u;
+            fs_emit_pos += skip;
+            off += skip;
+            continue;
         }
-        for (int i = ri-1; i >= 0; i--) sizebuf[si++] = rev[i];
-        sizebuf[si] = 0;
-        strcat((char*)p, sizebuf); p += strlen(sizebuf);
-        *p++ = ':';
-        if (node->type != TYPE_DIR && node->content) {
-            for (uint32_t i = 0; i < node->size; i++) {
-                *p++ = node->content[i];
+        uint32_t chunk = 512 - sec_off;
+        if (chunk > n - off) chunk = n - off;
+        fs_content_read(NULL, at, n, off, piece, chunk, NULL);
+        fs_emit_bytes(piece, chunk, false);
+        off += chunk;
+    }
+}
+
+static int fs_format_header(FileNode* node, uint32_t ref, char* header);
+
+// 저장이 끝난 뒤: 디스크에 기록된 내용의 메모리 사본을 반환 (필요할 때 다시 읽음).
+// 노드 안의 내용은 레코드 머리말 바로 뒤에 있으므로 머리말 길이만 남김.
+// 기록에 실패했으면 디스크 위치를 버리고 메모리 사본을 그대로 씀
+static void fs_spill_contents(bool written) {
+    char header[256 + 48];
+    for (FileNode* node = fs_root; node; node = node->next) {
+        FileContent* c = fs_node_content(node);
+        if (!c->data) continue;
+        if (node->shared) {
+            FileExtent* ext = node->share.extent;
+            if (ext->disk_off == FS_POS_NONE) continue;
+            if (!written) {
+                ext->disk_off = FS_POS_NONE;
+                continue;
             }
+            fs_content_free(c);
+        } else if (written && node->type != TYPE_DIR) {
+            fs_content_free(c);
+            c->capacity = (uint32_t)fs_format_header(node, FS_REF_NONE, header);
         }
-        *p++ = '}';
     }
-    *p = 0;
+}
 
-    int sectors = (p - fs_disk_cache + 511) / 512;
-    for (int i = 0; i < sectors; i++) {
-        ata_write_sector(FS_DISK_START_LBA + i, &fs_disk_cache[i * 512]);
+// 공유 extent: 처음 나온 노드만 내용을 기록, 나머지는 그 레코드 번호만
+static uint32_t fs_record_ref(FileNode* node, uint32_t record) {
+    if (!node->shared) return FS_REF_NONE;
+    FileExtent* ext = node->share.extent;
+    if (ext->save_gen != fs_save_gen) {
+        ext->save_gen = fs_save_gen;
+        ext->disk_id = record;
+        return FS_REF_NONE;
     }
+    return ext->disk_id;
 }
 
-static void fs_list() {
-    FileNode* node = fs_root;
-    while (node) {
-        vga_write(node->path);
-        vga_write(" [");
-        vga_write(type_to_str(node->type));
-        vga_write("] ");
-
-        // 파일 크기 표시
-        char sizebuf[16];
-        int si = 0;
-        uint32_t temp = node->size;
-        char rev[16];
-        int ri = 0;
-        if (temp == 0) rev[ri++] = '0';
-        while (temp) {
-            rev[ri++] = '0' + (temp % 10);
-            temp /= 10;
+static int fs_format_header(FileNode* node, uint32_t ref, char* header) {
+    int h = 0;
+    header[h++] = '{';
+    h += path_format(node->path_id, header + h);
+    header[h++] = ':';
+    const char* tstr = type_to_str(node->type);
+    int tlen = strlen(tstr);
+    memcpy(header + h, tstr, tlen); h += tlen;
+    header[h++] = ':';
+    h += fs_format_num(header + h, node->size);
+    if (ref != FS_REF_NONE) {
+        header[h++] = '&';
+        h += fs_format_num(header + h, ref);
+    }
+    header[h++] = ':';
+    return h;
+}
+
+// 바뀐 레코드라도 내용이 디스크의 같은 자리에 남으면 (크기만 줄었거나 머리말 길이가
+// 같으면) 내용은 메모리로 올리지도, 다시 쓰지도 않음
+static bool fs_content_stays(FileNode* node, uint64_t pos, int h) {
+    return fs_node_disk_off(node) == (uint64_t)FS_IMAGE_START_LBA * 512 + pos + h;
+}
+
+static void fs_save() {
+    TRACE_BEGIN(TRACE_CAT_FS, TRACE_EV_FS_SAVE, 0);
+    fs_emit_pos = 0;
+    fs_wr_dirty = false;
+    fs_wr_overflow = false;
+    fs_wr_failed = false;
+    fs_root = fs_reverse(fs_root);
+    char header[256 + 48];
+
+    // 1) 새 위치 계산: 자리가 바뀌는 레코드의 내용은 옛 위치가 덮이기 전에 메모리로
+    fs_save_gen++;
+    uint64_t pos = 0;
+    uint32_t record = 0;
+    for (FileNode* node = fs_root; node; node = node->next, record++) {
+        // 혼자 남은 공유 extent 는 노드 안으로 되돌림
+        if (node->shared && node->share.extent->refcount == 1) fs_node_unshare(node);
+        uint32_t ref = fs_record_ref(node, record);
+        bool content = node->type != TYPE_DIR && ref == FS_REF_NONE;
+        bool dirty = node->dirty || node->disk_pos != pos || fs_node_ref(node) != ref;
+        int h = fs_format_header(node, ref, header);
+        if (dirty && content && !fs_content_stays(node, pos, h)) fs_node_load(node);
+        pos += h + (content ? node->size : 0) + 1;
+    }
+
+    // 2) 기록
+    fs_save_gen++;
+    record = 0;
+    for (FileNode* node = fs_root; node; node = node->next, record++) {
+        uint32_t ref = fs_record_ref(node, record);
+        bool dirty = node->dirty || node->disk_pos != fs_emit_pos || fs_node_ref(node) != ref;
+        int h = fs_format_header(node, ref, header);
+        bool rewrite = dirty && !fs_content_stays(node, fs_emit_pos, h);
+        node->disk_pos = fs_emit_pos;
+        if (node->shared) node->share.disk_ref = ref;
+        node->dirty = false;
+
+        fs_emit_bytes((const uint8_t*)header, h, dirty);
+        if (node->type != TYPE_DIR && ref == FS_REF_NONE) {
+            fs_emit_content(node, node->size, rewrite);
         }
-        for (int i = ri-1; i >= 0; i--) sizebuf[si++] = rev[i];
-        sizebuf[si] = 0;
+        fs_emit_bytes((const uint8_t*)"}", 1, dirty);
+    }
+    fs_root = fs_reverse(fs_root);
 
-        vga_write(sizebuf);
-        vga_write(" bytes\n");
+    // 끝 표시 + 마지막 섹터 (이미지 길이가 그대로면 끝 표시도 그대로)
+    fs_emit_bytes((const uint8_t*)"", 1, fs_emit_pos + 1 != fs_image_len);
+    if (fs_emit_pos % 512) fs_wr_flush();
+    fs_wr_wait();
 
-        node = node->next;
+    // 슈퍼블록은 이미지가 모두 기록된 뒤에
+    if (fs_emit_pos != fs_image_len) {
+        FsSuperblock sb;
+        memset(&sb, 0, sizeof(sb));
+        memcpy(sb.magic, FS_MAGIC, 8);
+        sb.image_len = fs_emit_pos;
+        fs_disk_write(FS_SUPERBLOCK_LBA, 1, (const uint8_t*)&sb);
+        fs_wr_wait();
+        fs_image_len = fs_emit_pos;
     }
+    fs_spill_contents(!fs_wr_overflow && !fs_wr_failed);
+    if (fs_wr_overflow) vga_write("[FS] Disk full, image truncated.\n");
+    if (fs_wr_failed) vga_write("[FS] Write error.\n");
+    TRACE_END(TRACE_CAT_FS, TRACE_EV_FS_SAVE, (uint32_t)fs_emit_pos);
 }
 
-// 파일 읽기
-static bool fs_read(const char* path, uint8_t* out_buf, uint32_t* out_size) {
-    FileNode* node = fs_root;
-    while (node) {
-        if (streq(node->path, path) && node->type != TYPE_DIR) {
-            for (uint32_t i = 0; i < node->size; i++) {
-                out_buf[i] = node->content[i];
+static void fs_list() {
+    char path[PATH_MAX_LEN + 1];
+    for (uint8_t m = 0; m < fs_mount_count; m++) {
+        FileNode* node = *fs_mount_list(m);
+        while (node) {
+            if (fs_node_shadowed(node, m)) {
+                node = node->next;
+                continue;
+            }
+            path_format(node->path_id, path);
+            vga_write(path);
+            vga_write(" [");
+            vga_write(type_to_str(node->type));
+            vga_write("] ");
+
+            // 파일 크기 표시
+            char sizebuf[16];
+            int si = 0;
+            uint32_t temp = node->size;
+            char rev[16];
+            int ri = 0;
+            if (temp == 0) rev[ri++] = '0';
+            while (temp) {
+                rev[ri++] = '0' + (temp % 10);
+                temp /= 10;
             }
-            *out_size = node->size;
-            return true;
+            for (int i = ri-1; i >= 0; i--) sizebuf[si++] = rev[i];
+            sizebuf[si] = 0;
+
+            vga_write(sizebuf);
+            vga_write(" bytes\n");
+
+            node = node->next;
         }
-        node = node->next;
     }
-    return false;
 }
 
-// 파일 생성
+// 파일 읽기
+static bool fs_read(const char* path, uint8_t* out_buf, uint32_t* out_size) {
+    FileNode* node = fs_lookup(path);
+    if (!node || node->type == TYPE_DIR) return false;
+    fs_node_read(node, 0, out_buf, node->size, NULL);
+    *out_size = node->size;
+    return true;
+}
+
+// 변경 반영: 디스크 마운트만 이미지를 다시 기록 (tmpfs 는 할 일 없음)
+static void fs_sync(uint8_t mount) {
+    if (fs_mounts[mount].type == MOUNT_DISK) fs_save();
+}
+
+// 파일 크기가 old_size → new_size 로 바뀌기 전 tmpfs 한도 확인 후 사용량 반영 (디스크는 항상 통과)
+static bool fs_charge(uint8_t mount, uint32_t old_size, uint32_t new_size) {
+    FsMount* m = &fs_mounts[mount];
+    if (m->type == MOUNT_DISK) return true;
+    uint32_t used = m->used - old_size + new_size;
+    if (m->limit && new_size > old_size && used > m->limit) {
+        vga_write("[TMPFS] No space left.\n");
+        return false;
+    }
+    m->used = used;
+    return true;
+}
+
+// 노드를 마운트 목록에서 빼기
+static void fs_unlink(FileNode* node) {
+    FileNode** link = fs_mount_list(node->mount);
+    while (*link && *link != node) link = &(*link)->next;
+    if (*link) *link = node->next;
+}
+
+// 새 노드를 경로를 맡은 마운트 목록 맨 앞에 추가 (디스크면 다음 저장 때 이미지 끝에 기록됨)
+static FileNode* fs_node_new(uint32_t path_id, FileType type) {
+    FileNode* node = fs_node_alloc();
+    node->path_id = path_id;
+    node->mount = fs_mount_of(node->path_id);
+    node->type = type;
+    node->size = 0;
+    node->shared = false;
+    fs_content_init(&node->own);
+    node->disk_pos = FS_POS_NONE;
+    node->dirty = true;
+    FileNode** list = fs_mount_list(node->mount);
+    node->next = *list;
+    *list = node;
+    return node;
+}
+
+// 파일 생성 (같은 경로가 있으면 내용 교체 — 공유 중이던 extent 는 다른 쪽에 그대로 남음)
 static void fs_create(const char* path, FileType type, const uint8_t* data, uint32_t size) {
-    FileNode* node = (FileNode*) malloc(sizeof(FileNode));
-    strcpy(node->path, path);
+    TRACE_BEGIN(TRACE_CAT_FS, TRACE_EV_FS_CREATE, size);
+    FileNode* node = fs_lookup(path);
+    uint32_t path_id = node ? node->path_id : fs_intern(path);
+    // 마운트 지점은 디렉터리로만 남김
+    bool bad = path_id == PATH_NONE || (type != TYPE_DIR && fs_is_mount_point(path_id));
+    if (bad || !fs_charge(fs_mount_of(path_id), node ? node->size : 0, size)) {
+        TRACE_END(TRACE_CAT_FS, TRACE_EV_FS_CREATE, 0);
+        return;
+    }
+    if (node) {
+        fs_node_drop(node);
+    } else {
+        node = fs_node_new(path_id, type);
+    }
     node->type = type;
     node->size = size;
-    node->content = 0;
-    if (type != TYPE_DIR && data) {
-        node->content = (uint8_t*) malloc(size);
-        for (uint32_t i = 0; i < size; i++) node->content[i] = data[i];
+    node->dirty = true;
+    // 내용 없이 크기만 주면 0 으로 채움 (이미지에 크기만큼 기록되므로)
+    if (type != TYPE_DIR && (data || size)) fs_content_set(&node->own, data, size);
+    fs_sync(node->mount);
+    TRACE_END(TRACE_CAT_FS, TRACE_EV_FS_CREATE, node->path_id);
+}
+// ---- 열린 파일 테이블 ----
+
+#define FS_MAX_OPEN_FILES 16
+
+#define FS_O_READ   (1 << 0)
+#define FS_O_WRITE  (1 << 1)
+#define FS_O_CREATE (1 << 2)  // 없으면 빈 파일 생성
+#define FS_O_TRUNC  (1 << 3)  // 열 때 크기 0으로
+
+typedef struct {
+    FileNode* node;   // NULL 이면 빈 슬롯
+    uint32_t flags;
+    bool dirty;       // 닫을 때 fs_save 필요
+    ReadaheadState ra;  // 이 핸들의 접근 패턴 (미리 읽기 창)
+} OpenFile;
+
+static OpenFile fs_open_files[FS_MAX_OPEN_FILES];
+
+static OpenFile* fs_handle(int fd) {
+    if (fd < 0 || fd >= FS_MAX_OPEN_FILES || !fs_open_files[fd].node) return NULL;
+    return &fs_open_files[fd];
+}
+
+// 삭제된 노드를 가리키는 핸들 무효화
+static void fs_handles_forget(FileNode* node) {
+    for (int i = 0; i < FS_MAX_OPEN_FILES; i++) {
+        if (fs_open_files[i].node == node) fs_open_files[i].node = NULL;
     }
-    node->next = fs_root;
-    fs_root = node;
-    fs_save();
 }
-// 파일/폴더 삭제
-static bool fs_delete(const char* path) {
-    FileNode* prev = NULL;
-    FileNode* node = fs_root;
-    while (node) {
-        if (streq(node->path, path)) {
-            if (prev) {
-                prev->next = node->next;
-            } else {
-                fs_root = node->next;
-            }
-            if (node->content) free(node->content);
-            free(node);
-            fs_save();
-            return true;
+
+// 쓰기 전: 공유 중이면 분리(copy-on-write), 용량이 모자라면 두 배씩 늘림
+static FileContent* fs_node_writable(FileNode* node, uint32_t need) {
+    fs_node_private(node);
+    FileContent* c = &node->own;
+    if (need > c->capacity) {
+        uint32_t cap = c->capacity ? c->capacity : 64;
+        while (cap < need) cap *= 2;
+        uint8_t* data = (uint8_t*) malloc(cap);
+        if (c->data) memcpy(data, c->data, node->size);
+        free(c->data);
+        c->data = data;
+        c->capacity = cap;
+    }
+    return c;
+}
+
+// 파일 열기 (실패 시 -1)
+static int fs_open(const char* path, uint32_t flags) {
+    int fd = 0;
+    while (fd < FS_MAX_OPEN_FILES && fs_open_files[fd].node) fd++;
+    if (fd == FS_MAX_OPEN_FILES) return -1;
+
+    bool dirty = false;
+    FileNode* node = fs_lookup(path);
+    if (!node) {
+        if (!(flags & FS_O_CREATE)) return -1;
+        uint32_t path_id = fs_intern(path);
+        if (path_id == PATH_NONE) return -1;
+        node = fs_node_new(path_id, TYPE_FILE);
+        dirty = true;
+    } else if (node->type == TYPE_DIR) {
+        return -1;
+    }
+
+    if ((flags & FS_O_TRUNC) && node->size) {
+        fs_charge(node->mount, node->size, 0);
+        fs_node_drop(node);
+        node->size = 0;
+        node->dirty = true;
+        dirty = true;
+    }
+    fs_open_files[fd].node = node;
+    fs_open_files[fd].flags = flags;
+    fs_open_files[fd].dirty = dirty;
+    uint64_t at = fs_node_disk_off(node);
+    if (at != FS_POS_NONE) {
+        ra_stream_init(&fs_open_files[fd].ra, at, at + node->size);
+    } else {
+        ra_stream_init(&fs_open_files[fd].ra, 0, 0);
+    }
+    TRACE_MARK(TRACE_CAT_FS, TRACE_EV_FS_OPEN, fd);
+    return fd;
+}
+
+static uint32_t fs_size(int fd) {
+    OpenFile* f = fs_handle(fd);
+    return f ? f->node->size : 0;
+}
+
+// offset 부터 최대 len 바이트 읽기 (읽은 바이트 수, 끝이면 0)
+static uint32_t fs_read_at(int fd, uint32_t offset, uint8_t* buf, uint32_t len) {
+    OpenFile* f = fs_handle(fd);
+    if (!f || !(f->flags & FS_O_READ)) return 0;
+    FileNode* node = f->node;
+    if (offset >= node->size) return 0;
+    if (len > node->size - offset) len = node->size - offset;
+    TRACE_BEGIN(TRACE_CAT_FS, TRACE_EV_FS_READ_AT, offset);
+    fs_node_read(node, offset, buf, len, &f->ra);
+    TRACE_END(TRACE_CAT_FS, TRACE_EV_FS_READ_AT, len);
+    return len;
+}
+
+// 디스크 위치 at 에 제자리 덮어쓰기 (레코드 길이가 그대로라 이미지를 다시 쓰지 않음).
+// 걸친 양 끝 섹터만 읽어 고치고, 통째로 덮는 섹터는 buf 에서 바로 씀
+static bool fs_write_through(uint64_t at, const uint8_t* buf, uint32_t len) {
+    uint8_t edge[2][512];
+    uint32_t edges = 0;
+    uint64_t pos = at, end = at + len;
+    fs_wr_failed = false;
+    while (pos < end) {
+        uint64_t lba = pos / 512;
+        uint32_t off = (uint32_t)(pos % 512);
+        uint32_t chunk;
+        if (off == 0 && end - pos >= 512) {
+            uint32_t count = (uint32_t)((end - pos) / 512);
+            fs_disk_write(lba, count, buf);
+            chunk = count * 512;
+        } else {
+            chunk = 512 - off;
+            if (chunk > end - pos) chunk = (uint32_t)(end - pos);
+            uint8_t* sec = edge[edges++];
+            if (!block_read(lba, 1, sec)) fs_wr_failed = true;
+            memcpy(sec + off, buf, chunk);
+            fs_disk_write(lba, 1, sec);
         }
-        prev = node;
-        node = node->next;
+        pos += chunk;
+        buf += chunk;
     }
-    return false;
+    fs_wr_wait();
+    return !fs_wr_failed;
+}
+
+// offset 에 len 바이트 쓰기 (파일 끝을 넘으면 늘어나고, 빈 구간은 0)
+// 디스크에만 있는 단독 내용의 안쪽을 덮을 때는 파일을 메모리로 올리지 않고 그 섹터만 씀
+static uint32_t fs_write_at(int fd, uint32_t offset, const uint8_t* buf, uint32_t len) {
+    OpenFile* f = fs_handle(fd);
+    if (!f || !(f->flags & FS_O_WRITE)) return 0;
+    FileNode* node = f->node;
+    uint32_t end = offset + len;
+    if (end < offset) return 0;   // 32비트 넘침
+    if (end > node->size && !fs_charge(node->mount, node->size, end)) return 0;
+    TRACE_BEGIN(TRACE_CAT_FS, TRACE_EV_FS_WRITE_AT, offset);
+    uint64_t at = node->shared ? FS_POS_NONE : fs_node_disk_off(node);
+    if (at != FS_POS_NONE && end <= node->size) {
+        bool ok = fs_write_through(at + offset, buf, len);
+        TRACE_END(TRACE_CAT_FS, TRACE_EV_FS_WRITE_AT, ok ? len : 0);
+        if (!ok) {
+            vga_write("[FS] Write error.\n");
+            return 0;
+        }
+        return len;
+    }
+    FileContent* c = fs_node_writable(node, end > node->size ? end : node->size);
+    if (offset > node->size) memset(c->data + node->size, 0, offset - node->size);
+    memcpy(c->data + offset, buf, len);
+    if (end > node->size) node->size = end;
+    node->dirty = true;
+    f->dirty = true;
+    TRACE_END(TRACE_CAT_FS, TRACE_EV_FS_WRITE_AT, len);
+    return len;
+}
+
+static uint32_t fs_append(int fd, const uint8_t* buf, uint32_t len) {
+    OpenFile* f = fs_handle(fd);
+    if (!f) return 0;
+    return fs_write_at(fd, f->node->size, buf, len);
+}
+
+static bool fs_truncate(int fd, uint32_t size) {
+    OpenFile* f = fs_handle(fd);
+    if (!f || !(f->flags & FS_O_WRITE)) return false;
+    FileNode* node = f->node;
+    if (size == node->size) return true;
+    if (!fs_charge(node->mount, node->size, size)) return false;
+    if (size < node->size) {
+        // 줄일 때는 크기만 (내용은 제자리, 저장 때 앞부분만 기록).
+        // 공유 내용은 다른 파일이 전체를 참조하므로 남길 만큼 떼어 옴
+        node->size = size;
+        fs_node_unshare(node);
+    } else {
+        FileContent* c = fs_node_writable(node, size);
+        memset(c->data + node->size, 0, size - node->size);
+        node->size = size;
+    }
+    node->dirty = true;
+    f->dirty = true;
+    return true;
+}
+
+// 닫기: 변경이 있었을 때만 디스크에 반영
+static void fs_close(int fd) {
+    OpenFile* f = fs_handle(fd);
+    if (!f) return;
+    bool dirty = f->dirty;
+    uint8_t mount = f->node->mount;
+    f->node = NULL;
+    TRACE_MARK(TRACE_CAT_FS, TRACE_EV_FS_CLOSE, fd);
+    if (dirty) fs_sync(mount);
+}
+
+// 파일/폴더 삭제
+// 마운트 지점은 umount 로만 없앰
+static bool fs_delete(const char* path) {
+    FileNode* node = fs_lookup(path);
+    if (!node || fs_is_mount_point(node->path_id)) return false;
+    TRACE_MARK(TRACE_CAT_FS, TRACE_EV_FS_DELETE, node->path_id);
+    uint8_t mount = node->mount;
+    fs_charge(mount, node->size, 0);
+    fs_unlink(node);
+    fs_handles_forget(node);
+    fs_node_drop(node);
+    fs_node_release(node);
+    fs_sync(mount);
+    return true;
 }
 
 // 파일/폴더 이름 변경 (move)
+// 다른 마운트로 옮기면 노드를 그쪽 목록으로 (tmpfs 로 갈 때는 내용을 메모리로)
 static bool fs_move(const char* old_path, const char* new_path) {
-    FileNode* node = fs_root;
-    while (node) {
-        if (streq(node->path, old_path)) {
-            strcpy(node->path, new_path);
-            fs_save();
-            return true;
-        }
-        node = node->next;
+    FileNode* node = fs_lookup(old_path);
+    if (!node || fs_is_mount_point(node->path_id)) return false;
+    uint32_t path_id = fs_intern(new_path);
+    if (path_id == PATH_NONE || fs_is_mount_point(path_id)) return false;
+    uint8_t from = node->mount, to = fs_mount_of(path_id);
+    if (to != from) {
+        if (!fs_charge(to, 0, node->size)) return false;
+        fs_charge(from, node->size, 0);
+        fs_unlink(node);
+        node->mount = to;
+        // tmpfs 와 디스크 사이에서는 공유를 끊음 (디스크 쪽은 저장 뒤 메모리를 반환하므로)
+        if (fs_mounts[to].type != fs_mounts[from].type) fs_node_private(node);
+        FileNode** list = fs_mount_list(to);
+        node->next = *list;
+        *list = node;
+        node->disk_pos = FS_POS_NONE;
     }
-    return false;
+    node->path_id = path_id;
+    TRACE_MARK(TRACE_CAT_FS, TRACE_EV_FS_MOVE, path_id);
+    node->dirty = true;
+    fs_sync(from);
+    if (to != from) fs_sync(to);
+    return true;
 }
 
-// 파일 복제
+// 파일 복제 (내용은 복사하지 않고 extent 공유, 쓰기 시 분리)
 static bool fs_copy(const char* src_path, const char* dest_path) {
-    FileNode* node = fs_root;
-    while (node) {
-        if (streq(node->path, src_path)) {
-            fs_create(dest_path, node->type, node->content, node->size);
-            return true;
+    FileNode* src = fs_lookup(src_path);
+    if (!src) return false;
+    if (src == fs_lookup(dest_path)) return true;
+
+    FileNode* node = fs_lookup(dest_path);
+    uint32_t path_id = node ? node->path_id : fs_intern(dest_path);
+    if (path_id == PATH_NONE || fs_is_mount_point(path_id)) return false;
+    if (!fs_charge(fs_mount_of(path_id), node ? node->size : 0, src->size)) return false;
+    if (!node) node = fs_node_new(path_id, src->type);
+    fs_node_drop(node);
+    node->type = src->type;
+    node->size = src->size;
+    node->dirty = true;
+    if (src->type != TYPE_DIR) {
+        if (fs_mounts[node->mount].type != fs_mounts[src->mount].type) {
+            // 마운트 종류가 다르면 공유하지 않음 (fs_move 와 같은 이유)
+            fs_content_set(&node->own, NULL, src->size);
+            fs_node_read(src, 0, node->own.data, src->size, NULL);
+        } else {
+            // 처음 복제될 때에야 공유 extent 를 만듦
+            FileExtent* ext = fs_node_share(src);
+            node->shared = true;
+            node->share.extent = ext;
+            node->share.disk_ref = FS_REF_NONE;
+        }
+    }
+    fs_sync(node->mount);
+    return true;
+}
+
+// tmpfs 마운트 해제 (안의 파일은 모두 사라짐)
+static bool fs_unmount(const char* path) {
+    uint32_t path_id = path_find(path);
+    for (uint32_t m = 1; m < fs_mount_count; m++) {
+        if (fs_mounts[m].path_id != path_id) continue;
+        FileNode* node = fs_mounts[m].nodes;
+        while (node) {
+            FileNode* next = node->next;
+            fs_handles_forget(node);
+            fs_node_drop(node);
+            fs_node_release(node);
+            node = next;
+        }
+        // 뒤 항목을 당기고 노드의 마운트 번호도 맞춤
+        for (uint32_t k = m + 1; k < fs_mount_count; k++) {
+            fs_mounts[k - 1] = fs_mounts[k];
+            for (FileNode* n = fs_mounts[k - 1].nodes; n; n = n->next) n->mount = (uint8_t)(k - 1);
         }
-        node = node->next;
+        fs_mount_count--;
+        return true;
     }
     return false;
 }
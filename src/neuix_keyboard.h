@@ -5,6 +5,7 @@
 #include <stdbool.h>
 #include "io.h"
 #include "neuix_vga.h"
+#include "neuix_trace.h"
 
 #define KEYBOARD_DATA_PORT 0x60
 #define KEYBOARD_STATUS_PORT 0x64
@@ -33,10 +34,8 @@ static char scancode_to_char(uint8_t scancode) {
     return 0;
 }
 
-// 키보드 인터럽트 핸들러
-void keyboard_isr_handler() {
-    uint8_t scancode = inb(KEYBOARD_DATA_PORT);
-
+// 스캔코드 하나 처리
+static void keyboard_handle_scancode(uint8_t scancode) {
     if (scancode & 0x80) {
         return; // release는 무시
     }
@@ -70,6 +69,14 @@ void keyboard_isr_handler() {
     }
 }
 
+// 키보드 인터럽트 핸들러 (진입·복귀 추적, arg = 스캔코드)
+void keyboard_isr_handler() {
+    TRACE_BEGIN(TRACE_CAT_IRQ, TRACE_EV_IRQ_KEYBOARD, 0);
+    uint8_t scancode = inb(KEYBOARD_DATA_PORT);
+    keyboard_handle_scancode(scancode);
+    TRACE_END(TRACE_CAT_IRQ, TRACE_EV_IRQ_KEYBOARD, scancode);
+}
+
 // 입력 버퍼 가져오기
 const char* keyboard_get_buffer() {
     input_buffer[buffer_index] = '\0';
@@ -89,9 +96,7 @@ char getchar() {
     while (true) {
         if (buffer_index > 0) {
             char c = input_buffer[0];
-            for (int i = 0; i < buffer_index - 1; i++) {
-                input_buffer[i] = input_buffer[i + 1];
-            }
+            memmove(input_buffer, input_buffer + 1, buffer_index - 1);
             buffer_index--;
             input_buffer[buffer_index] = '\0';
             return c;
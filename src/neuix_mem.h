@@ -0,0 +1,287 @@
+// neuix_mem.h – Neuix OS 메모리/문자열 기본 함수
+// 부팅 시 CPUID 로 ERMS(rep movsb/stosb) / SSE2 구현을 골라 사용
+
+#ifndef NEUIX_MEM_H
+#define NEUIX_MEM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 이 크기 미만은 분기/함수 포인터 비용이 더 커서 바이트 루프 사용
+#define MEM_SMALL_COPY 32
+
+typedef void* (*mem_copy_fn)(void*, const void*, uint32_t);
+typedef void* (*mem_set_fn)(void*, int, uint32_t);
+typedef int   (*mem_cmp_fn)(const void*, const void*, uint32_t);
+typedef int   (*str_len_fn)(const char*);
+typedef int   (*str_cmp_fn)(const char*, const char*);
+
+static bool cpu_has_sse2 = false;
+static bool cpu_has_erms = false;
+
+static inline void cpuid(uint32_t leaf, uint32_t sub, uint32_t* a, uint32_t* b, uint32_t* c, uint32_t* d) {
+    __asm__ volatile ("cpuid" : "=a"(*a), "=b"(*b), "=c"(*c), "=d"(*d) : "a"(leaf), "c"(sub));
+}
+
+// ---- 기존 바이트 루프 (작은 크기 / 폴백 / 벤치마크 기준) ----
+
+static void* memcpy_bytes(void* dst, const void* src, uint32_t n) {
+    uint8_t* d = (uint8_t*)dst;
+    const uint8_t* s = (const uint8_t*)src;
+    for (uint32_t i = 0; i < n; i++) d[i] = s[i];
+    return dst;
+}
+
+static void* memset_bytes(void* dst, int c, uint32_t n) {
+    uint8_t* d = (uint8_t*)dst;
+    for (uint32_t i = 0; i < n; i++) d[i] = (uint8_t)c;
+    return dst;
+}
+
+static int memcmp_bytes(const void* a, const void* b, uint32_t n) {
+    const uint8_t* x = (const uint8_t*)a;
+    const uint8_t* y = (const uint8_t*)b;
+    for (uint32_t i = 0; i < n; i++) {
+        if (x[i] != y[i]) return x[i] - y[i];
+    }
+    return 0;
+}
+
+static int strlen_bytes(const char* s) { int i = 0; while (s[i]) i++; return i; }
+
+static int strcmp_bytes(const char* a, const char* b) {
+    while (*a && *a == *b) { a++; b++; }
+    return (uint8_t)*a - (uint8_t)*b;
+}
+
+// ---- ERMS: rep movsb / rep stosb ----
+
+static void* memcpy_erms(void* dst, const void* src, uint32_t n) {
+    void* d = dst;
+    __asm__ volatile ("rep movsb" : "+D"(d), "+S"(src), "+c"(n) : : "memory");
+    return dst;
+}
+
+static void* memset_erms(void* dst, int c, uint32_t n) {
+    void* d = dst;
+    __asm__ volatile ("rep stosb" : "+D"(d), "+c"(n) : "a"(c) : "memory");
+    return dst;
+}
+
+// ---- SSE2: 목적지를 16바이트 정렬 후 64바이트 단위 ----
+
+__attribute__((target("sse2")))
+static void* memcpy_sse2(void* dst, const void* src, uint32_t n) {
+    uint8_t* d = (uint8_t*)dst;
+    const uint8_t* s = (const uint8_t*)src;
+    while (n && ((uintptr_t)d & 15)) { *d++ = *s++; n--; }
+    while (n >= 64) {
+        __asm__ volatile (
+            "movdqu   (%0), %%xmm0\n\t"
+            "movdqu 16(%0), %%xmm1\n\t"
+            "movdqu 32(%0), %%xmm2\n\t"
+            "movdqu 48(%0), %%xmm3\n\t"
+            "movdqa %%xmm0,   (%1)\n\t"
+            "movdqa %%xmm1, 16(%1)\n\t"
+            "movdqa %%xmm2, 32(%1)\n\t"
+            "movdqa %%xmm3, 48(%1)\n\t"
+            : : "r"(s), "r"(d) : "memory", "xmm0", "xmm1", "xmm2", "xmm3");
+        s += 64; d += 64; n -= 64;
+    }
+    while (n >= 16) {
+        __asm__ volatile ("movdqu (%0), %%xmm0\n\tmovdqa %%xmm0, (%1)"
+                          : : "r"(s), "r"(d) : "memory", "xmm0");
+        s += 16; d += 16; n -= 16;
+    }
+    while (n--) *d++ = *s++;
+    return dst;
+}
+
+__attribute__((target("sse2")))
+static void* memset_sse2(void* dst, int c, uint32_t n) {
+    uint8_t* d = (uint8_t*)dst;
+    uint8_t pattern[16] __attribute__((aligned(16)));
+    for (int i = 0; i < 16; i++) pattern[i] = (uint8_t)c;
+    while (n && ((uintptr_t)d & 15)) { *d++ = (uint8_t)c; n--; }
+    if (n >= 16) {
+        __asm__ volatile ("movdqa (%0), %%xmm0" : : "r"(pattern) : "memory", "xmm0");
+        while (n >= 64) {
+            __asm__ volatile (
+                "movdqa %%xmm0,   (%0)\n\t"
+                "movdqa %%xmm0, 16(%0)\n\t"
+                "movdqa %%xmm0, 32(%0)\n\t"
+                "movdqa %%xmm0, 48(%0)\n\t"
+                : : "r"(d) : "memory");
+            d += 64; n -= 64;
+        }
+        while (n >= 16) {
+            __asm__ volatile ("movdqa %%xmm0, (%0)" : : "r"(d) : "memory");
+            d += 16; n -= 16;
+        }
+    }
+    while (n--) *d++ = (uint8_t)c;
+    return dst;
+}
+
+__attribute__((target("sse2")))
+static int memcmp_sse2(const void* a, const void* b, uint32_t n) {
+    const uint8_t* x = (const uint8_t*)a;
+    const uint8_t* y = (const uint8_t*)b;
+    while (n >= 16) {
+        uint32_t mask;
+        __asm__ volatile (
+            "movdqu (%1), %%xmm0\n\t"
+            "movdqu (%2), %%xmm1\n\t"
+            "pcmpeqb %%xmm1, %%xmm0\n\t"
+            "pmovmskb %%xmm0, %0\n\t"
+            : "=r"(mask) : "r"(x), "r"(y) : "memory", "xmm0", "xmm1");
+        if (mask != 0xFFFF) {
+            int i = __builtin_ctz(~mask);
+            return x[i] - y[i];
+        }
+        x += 16; y += 16; n -= 16;
+    }
+    return memcmp_bytes(x, y, n);
+}
+
+// 16바이트 정렬 단위로만 읽으므로 페이지 경계를 넘지 않음
+__attribute__((target("sse2")))
+static int strlen_sse2(const char* s) {
+    const char* p = (const char*)((uintptr_t)s & ~(uintptr_t)15);
+    uint32_t mask;
+    __asm__ volatile (
+        "pxor %%xmm0, %%xmm0\n\t"
+        "pcmpeqb (%1), %%xmm0\n\t"
+        "pmovmskb %%xmm0, %0\n\t"
+        : "=r"(mask) : "r"(p) : "memory", "xmm0");
+    mask &= 0xFFFFu << (s - p);
+    while (!mask) {
+        p += 16;
+        __asm__ volatile (
+            "pxor %%xmm0, %%xmm0\n\t"
+            "pcmpeqb (%1), %%xmm0\n\t"
+            "pmovmskb %%xmm0, %0\n\t"
+            : "=r"(mask) : "r"(p) : "memory", "xmm0");
+    }
+    return (int)(p - s) + __builtin_ctz(mask);
+}
+
+// 16바이트씩 비교하다 다르거나 NUL 인 첫 바이트에서 멈춤.
+// 어느 쪽이든 16바이트 읽기가 4KB 경계를 넘게 되면 그 구간만 바이트 단위로
+__attribute__((target("sse2")))
+static int strcmp_sse2(const char* a, const char* b) {
+    const uint8_t* x = (const uint8_t*)a;
+    const uint8_t* y = (const uint8_t*)b;
+    while (1) {
+        if (((uintptr_t)x & 4095) > 4096 - 16 || ((uintptr_t)y & 4095) > 4096 - 16) {
+            if (*x != *y || !*x) return *x - *y;
+            x++; y++;
+            continue;
+        }
+        uint32_t eq, nul;
+        __asm__ volatile (
+            "movdqu (%2), %%xmm0\n\t"
+            "movdqu (%3), %%xmm1\n\t"
+            "pxor %%xmm2, %%xmm2\n\t"
+            "pcmpeqb %%xmm0, %%xmm2\n\t"
+            "pcmpeqb %%xmm1, %%xmm0\n\t"
+            "pmovmskb %%xmm0, %0\n\t"
+            "pmovmskb %%xmm2, %1\n\t"
+            : "=&r"(eq), "=&r"(nul) : "r"(x), "r"(y) : "memory", "xmm0", "xmm1", "xmm2");
+        uint32_t stop = (~eq | nul) & 0xFFFF;
+        if (stop) {
+            int i = __builtin_ctz(stop);
+            return x[i] - y[i];
+        }
+        x += 16; y += 16;
+    }
+}
+
+// ---- 부팅 시 선택되는 구현 ----
+
+static mem_copy_fn mem_copy_impl = memcpy_bytes;
+static mem_set_fn  mem_set_impl  = memset_bytes;
+static mem_cmp_fn  mem_cmp_impl  = memcmp_bytes;
+static str_len_fn  str_len_impl  = strlen_bytes;
+static str_cmp_fn  str_cmp_impl  = strcmp_bytes;
+
+// CPUID 확인 후 구현 선택 (SSE2 사용 시 CR0/CR4 에서 SSE 활성화)
+static void mem_init() {
+    uint32_t a, b, c, d;
+    cpuid(0, 0, &a, &b, &c, &d);
+    uint32_t max_leaf = a;
+
+    cpuid(1, 0, &a, &b, &c, &d);
+    cpu_has_sse2 = (d >> 26) & 1;
+    if (max_leaf >= 7) {
+        cpuid(7, 0, &a, &b, &c, &d);
+        cpu_has_erms = (b >> 9) & 1;
+    }
+
+    if (cpu_has_sse2) {
+        uintptr_t cr0, cr4;
+        __asm__ volatile ("mov %%cr0, %0" : "=r"(cr0));
+        cr0 &= ~(uintptr_t)(1 << 2);   // EM 해제
+        cr0 |= (1 << 1);               // MP
+        __asm__ volatile ("mov %0, %%cr0" : : "r"(cr0));
+        __asm__ volatile ("mov %%cr4, %0" : "=r"(cr4));
+        cr4 |= (1 << 9) | (1 << 10);   // OSFXSR, OSXMMEXCPT
+        __asm__ volatile ("mov %0, %%cr4" : : "r"(cr4));
+
+        mem_copy_impl = memcpy_sse2;
+        mem_set_impl  = memset_sse2;
+        mem_cmp_impl  = memcmp_sse2;
+        str_len_impl  = strlen_sse2;
+        str_cmp_impl  = strcmp_sse2;
+    }
+    // 대용량 복사/채우기는 ERMS 가 가장 빠름
+    if (cpu_has_erms) {
+        mem_copy_impl = memcpy_erms;
+        mem_set_impl  = memset_erms;
+    }
+}
+
+// ---- 공개 함수 ----
+
+static void* memcpy(void* dst, const void* src, uint32_t n) {
+    if (n < MEM_SMALL_COPY) return memcpy_bytes(dst, src, n);
+    return mem_copy_impl(dst, src, n);
+}
+
+static void* memset(void* dst, int c, uint32_t n) {
+    if (n < MEM_SMALL_COPY) return memset_bytes(dst, c, n);
+    return mem_set_impl(dst, c, n);
+}
+
+// 겹치지 않으면 선택된 memcpy, 겹치면 rep movsb
+// (목적지가 앞쪽이면 앞에서부터, 뒤쪽이면 DF 를 세워 끝에서부터)
+static void* memmove(void* dst, const void* src, uint32_t n) {
+    uint8_t* d = (uint8_t*)dst;
+    const uint8_t* s = (const uint8_t*)src;
+    if (d == s || !n) return dst;
+    if (d + n <= s || s + n <= d) return memcpy(dst, src, n);
+    if (d < s) return memcpy_erms(dst, src, n);
+    d += n - 1;
+    s += n - 1;
+    __asm__ volatile ("std\n\trep movsb\n\tcld" : "+D"(d), "+S"(s), "+c"(n) : : "memory");
+    return dst;
+}
+
+static int memcmp(const void* a, const void* b, uint32_t n) {
+    if (n < MEM_SMALL_COPY) return memcmp_bytes(a, b, n);
+    return mem_cmp_impl(a, b, n);
+}
+
+// 16비트 단위 채우기 (VGA 버퍼 등)
+static void memset16(uint16_t* dst, uint16_t v, uint32_t count) {
+    __asm__ volatile ("rep stosw" : "+D"(dst), "+c"(count) : "a"(v) : "memory");
+}
+
+static int strlen(const char* s) { return str_len_impl(s); }
+
+static int strcmp(const char* a, const char* b) { return str_cmp_impl(a, b); }
+
+static void strcpy(char* dst, const char* src) { memcpy(dst, src, strlen(src) + 1); }
+static bool streq(const char* a, const char* b) { return strcmp(a, b) == 0; }
+
+#endif // NEUIX_MEM_H
@@ -0,0 +1,145 @@
+// neuix_membench.h – 메모리/문자열 함수 마이크로 벤치마크 (쉘 명령 membench)
+// 기존 바이트 루프와 ERMS / SSE2 구현을 크기별로 비교 (호출당 평균 사이클)
+
+#ifndef NEUIX_MEMBENCH_H
+#define NEUIX_MEMBENCH_H
+
+#include "io.h"
+#include "neuix_mem.h"
+#include "neuix_vga.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MEMBENCH_MAX_SIZE 65536
+#define MEMBENCH_BYTES_PER_RUN (1024 * 1024)  // 크기별로 대략 이만큼 처리
+
+// 고정 폭 숫자 출력
+static void membench_write_num(uint32_t v, int width) {
+    char rev[16];
+    int ri = 0;
+    if (v == 0) rev[ri++] = '0';
+    while (v) {
+        rev[ri++] = '0' + (v % 10);
+        v /= 10;
+    }
+    for (int i = ri; i < width; i++) vga_put_char(' ');
+    while (ri) vga_put_char(rev[--ri]);
+}
+
+static uint32_t membench_iters(uint32_t size) {
+    uint32_t n = MEMBENCH_BYTES_PER_RUN / size;
+    return n ? n : 1;
+}
+
+static uint32_t membench_copy(mem_copy_fn fn, uint8_t* dst, const uint8_t* src, uint32_t size) {
+    uint32_t iters = membench_iters(size);
+    uint64_t t0 = rdtsc();
+    for (uint32_t i = 0; i < iters; i++) fn(dst, src, size);
+    return (uint32_t)udiv64_32(rdtsc() - t0, iters, NULL);
+}
+
+static uint32_t membench_set(mem_set_fn fn, uint8_t* dst, uint32_t size) {
+    uint32_t iters = membench_iters(size);
+    uint64_t t0 = rdtsc();
+    for (uint32_t i = 0; i < iters; i++) fn(dst, (int)i, size);
+    return (uint32_t)udiv64_32(rdtsc() - t0, iters, NULL);
+}
+
+static uint32_t membench_cmp(mem_cmp_fn fn, const uint8_t* a, const uint8_t* b, uint32_t size) {
+    uint32_t iters = membench_iters(size);
+    volatile int sink = 0;
+    uint64_t t0 = rdtsc();
+    for (uint32_t i = 0; i < iters; i++) sink += fn(a, b, size);
+    (void)sink;
+    return (uint32_t)udiv64_32(rdtsc() - t0, iters, NULL);
+}
+
+static uint32_t membench_len(str_len_fn fn, const char* s, uint32_t size) {
+    uint32_t iters = membench_iters(size);
+    volatile int sink = 0;
+    uint64_t t0 = rdtsc();
+    for (uint32_t i = 0; i < iters; i++) sink += fn(s);
+    (void)sink;
+    return (uint32_t)udiv64_32(rdtsc() - t0, iters, NULL);
+}
+
+static uint32_t membench_strcmp(str_cmp_fn fn, const char* a, const char* b, uint32_t size) {
+    uint32_t iters = membench_iters(size);
+    volatile int sink = 0;
+    uint64_t t0 = rdtsc();
+    for (uint32_t i = 0; i < iters; i++) sink += fn(a, b);
+    (void)sink;
+    return (uint32_t)udiv64_32(rdtsc() - t0, iters, NULL);
+}
+
+static void membench_run() {
+    static const uint32_t sizes[] = { 16, 64, 256, 1024, 4096, 16384, 65536 };
+    // 목적지는 1바이트 어긋나게 두어 정렬 처리 경로도 측정
+    static uint8_t buf_a[MEMBENCH_MAX_SIZE + 16] __attribute__((aligned(16)));
+    static uint8_t buf_b[MEMBENCH_MAX_SIZE + 16] __attribute__((aligned(16)));
+    uint8_t* src = buf_a;
+    uint8_t* dst = buf_b + 1;
+
+    memset_bytes(buf_a, 'a', sizeof(buf_a));
+    memset_bytes(buf_b, 'a', sizeof(buf_b));
+
+    vga_write("CPU: sse2=");
+    vga_write(cpu_has_sse2 ? "yes" : "no");
+    vga_write(" erms=");
+    vga_write(cpu_has_erms ? "yes" : "no");
+    vga_write("  (cycles/call)\n");
+
+    vga_write(" size | memcpy:   loop    erms    sse2 | memset:   loop    erms    sse2\n");
+    for (uint32_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        uint32_t size = sizes[k];
+        membench_write_num(size, 5);
+        vga_write(" |        ");
+        membench_write_num(membench_copy(memcpy_bytes, dst, src, size), 7);
+        if (cpu_has_erms) membench_write_num(membench_copy(memcpy_erms, dst, src, size), 8);
+        else vga_write("       -");
+        if (cpu_has_sse2) membench_write_num(membench_copy(memcpy_sse2, dst, src, size), 8);
+        else vga_write("       -");
+        vga_write(" |        ");
+        membench_write_num(membench_set(memset_bytes, dst, size), 7);
+        if (cpu_has_erms) membench_write_num(membench_set(memset_erms, dst, size), 8);
+        else vga_write("       -");
+        if (cpu_has_sse2) membench_write_num(membench_set(memset_sse2, dst, size), 8);
+        else vga_write("       -");
+        vga_write("\n");
+    }
+
+    memset_bytes(buf_b, 'a', sizeof(buf_b));
+    vga_write(" size | memcmp:   loop    sse2 | strlen:   loop    sse2\n");
+    for (uint32_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        uint32_t size = sizes[k];
+        membench_write_num(size, 5);
+        vga_write(" |        ");
+        membench_write_num(membench_cmp(memcmp_bytes, src, dst, size), 7);
+        if (cpu_has_sse2) membench_write_num(membench_cmp(memcmp_sse2, src, dst, size), 8);
+        else vga_write("       -");
+        vga_write(" |        ");
+        src[size] = 0;
+        membench_write_num(membench_len(strlen_bytes, (const char*)src, size), 7);
+        if (cpu_has_sse2) membench_write_num(membench_len(strlen_sse2, (const char*)src, size), 8);
+        else vga_write("       -");
+        src[size] = 'a';
+        vga_write("\n");
+    }
+
+    vga_write(" size | strcmp:   loop    sse2\n");
+    for (uint32_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        uint32_t size = sizes[k];
+        src[size] = 0;
+        dst[size] = 0;
+        membench_write_num(size, 5);
+        vga_write(" |        ");
+        membench_write_num(membench_strcmp(strcmp_bytes, (const char*)src, (const char*)dst, size), 7);
+        if (cpu_has_sse2) membench_write_num(membench_strcmp(strcmp_sse2, (const char*)src, (const char*)dst, size), 8);
+        else vga_write("       -");
+        src[size] = 'a';
+        dst[size] = 'a';
+        vga_write("\n");
+    }
+}
+
+#endif // NEUIX_MEMBENCH_H
@@ -0,0 +1,246 @@
+// neuix_path.h – 경로 인터닝 (구성요소 이름 아레나 + 작은 정수 경로 ID)
+//
+// "/root/user/pass.txt" 같은 경로를 구성요소("root", "user", "pass.txt")로 나눠
+// 이름마다 한 번만 아레나에 저장하고, (부모 경로 ID, 이름 ID) 쌍을 경로 ID 로 만든다.
+// 같은 디렉터리의 파일들은 부모 경로를 공유하므로 파일당 비용은 자기 이름 + 항목 하나.
+// 항목은 지우지 않는다 (rename 후 옛 경로는 다시 쓰일 때까지 남음).
+// 이름/항목 테이블은 PATH_CHUNK 개씩 덩어리로 늘려 복사도, 두 배 확장의 빈 자리도 없다.
+// 해시 버킷은 작게 시작해 버킷당 평균 PATH_LOAD 개를 넘으면 두 배로 늘린다.
+// 정규화한 길이가 PATH_MAX_LEN 을 넘는 경로는 만들지 않는다 (path_format 이 자르지 않게).
+
+#ifndef NEUIX_PATH_H
+#define NEUIX_PATH_H
+
+#include "neuix_mem.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PATH_NONE        0xFFFFFFFF
+#define PATH_ROOT        0              // "/"
+#define PATH_MAX_LEN     255
+#define PATH_BUCKETS_MIN 64             // 이름/경로 해시 버킷 시작 크기 (2의 거듭제곱)
+#define PATH_LOAD        4              // 버킷당 평균 항목 수 상한
+#define PATH_ARENA_BLOCK 4096
+#define PATH_CHUNK_SHIFT 10
+#define PATH_CHUNK       (1u << PATH_CHUNK_SHIFT)   // 덩어리당 이름/항목 수
+
+typedef struct {
+    const char* str;    // 아레나 안, NUL 로 끝남
+    uint32_t hash_next;
+} PathName;
+
+typedef struct {
+    uint32_t parent;    // 부모 경로 ID (루트는 PATH_NONE)
+    uint32_t name;      // 이름 ID
+    uint32_t hash_next;
+} PathEntry;
+
+static char* path_arena = NULL;
+static uint32_t path_arena_left = 0;
+static uint32_t path_arena_bytes = 0;   // 아레나로 잡은 전체 바이트
+
+static PathName** path_name_chunks = NULL;
+static uint32_t path_name_count = 0, path_name_cap = 0;     // cap: 덩어리 포인터 배열 크기
+static PathEntry** path_entry_chunks = NULL;
+static uint32_t path_entry_count = 0, path_entry_cap = 0;
+
+static uint32_t* path_name_buckets = NULL;
+static uint32_t* path_entry_buckets = NULL;
+static uint32_t path_name_nbuckets = 0, path_entry_nbuckets = 0;
+
+static uint32_t path_hash(const char* s, uint32_t len) {
+    uint32_t h = 2166136261u;   // FNV-1a
+    for (uint32_t i = 0; i < len; i++) h = (h ^ (uint8_t)s[i]) * 16777619u;
+    return h;
+}
+
+static uint32_t path_pair_hash(uint32_t parent, uint32_t name) {
+    return (parent * 2654435761u) ^ (name * 40503u);
+}
+
+// 덩어리 포인터 배열에 덩어리 하나 추가 (포인터 배열만 두 배씩 늘림)
+static void** path_add_chunk(void** chunks, uint32_t count, uint32_t* cap, uint32_t elem) {
+    uint32_t n = count >> PATH_CHUNK_SHIFT;
+    if (n == *cap) {
+        uint32_t ncap = *cap ? *cap * 2 : 4;
+        void** p = (void**) malloc(ncap * sizeof(void*));
+        if (chunks) {
+            memcpy(p, chunks, n * sizeof(void*));
+            free(chunks);
+        }
+        chunks = p;
+        *cap = ncap;
+    }
+    chunks[n] = malloc(PATH_CHUNK * elem);
+    return chunks;
+}
+
+static uint32_t* path_buckets_new(uint32_t n) {
+    uint32_t* b = (uint32_t*) malloc(n * sizeof(uint32_t));
+    for (uint32_t i = 0; i < n; i++) b[i] = PATH_NONE;
+    return b;
+}
+
+static PathName* path_name(uint32_t id) {
+    return &path_name_chunks[id >> PATH_CHUNK_SHIFT][id & (PATH_CHUNK - 1)];
+}
+
+static PathEntry* path_entry(uint32_t id) {
+    return &path_entry_chunks[id >> PATH_CHUNK_SHIFT][id & (PATH_CHUNK - 1)];
+}
+
+static const char* path_arena_store(const char* s, uint32_t len) {
+    if (len + 1 > path_arena_left) {
+        uint32_t size = len + 1 > PATH_ARENA_BLOCK ? len + 1 : PATH_ARENA_BLOCK;
+        path_arena = (char*) malloc(size);
+        path_arena_left = size;
+        path_arena_bytes += size;
+    }
+    char* out = path_arena;
+    memcpy(out, s, len);
+    out[len] = 0;
+    path_arena += len + 1;
+    path_arena_left -= len + 1;
+    return out;
+}
+
+// 버킷 두 배로: 체인을 새 배열에 다시 건다 (항목 자체는 그대로)
+static void path_grow_names() {
+    uint32_t n = path_name_nbuckets * 2;
+    uint32_t* b = path_buckets_new(n);
+    for (uint32_t id = 0; id < path_name_count; id++) {
+        PathName* p = path_name(id);
+        uint32_t h = path_hash(p->str, strlen(p->str)) & (n - 1);
+        p->hash_next = b[h];
+        b[h] = id;
+    }
+    free(path_name_buckets);
+    path_name_buckets = b;
+    path_name_nbuckets = n;
+}
+
+static void path_grow_entries() {
+    uint32_t n = path_entry_nbuckets * 2;
+    uint32_t* b = path_buckets_new(n);
+    for (uint32_t id = 1; id < path_entry_count; id++) {
+        PathEntry* e = path_entry(id);
+        uint32_t h = path_pair_hash(e->parent, e->name) & (n - 1);
+        e->hash_next = b[h];
+        b[h] = id;
+    }
+    free(path_entry_buckets);
+    path_entry_buckets = b;
+    path_entry_nbuckets = n;
+}
+
+static void path_init() {
+    path_name_buckets = path_buckets_new(PATH_BUCKETS_MIN);
+    path_entry_buckets = path_buckets_new(PATH_BUCKETS_MIN);
+    path_name_nbuckets = path_entry_nbuckets = PATH_BUCKETS_MIN;
+    path_entry_chunks = (PathEntry**) path_add_chunk(NULL, 0, &path_entry_cap, sizeof(PathEntry));
+    PathEntry* root = path_entry(PATH_ROOT);
+    root->parent = PATH_NONE;
+    root->name = PATH_NONE;
+    root->hash_next = PATH_NONE;
+    path_entry_count = 1;
+}
+
+// 이름 ID (create 가 false 면 없을 때 PATH_NONE)
+static uint32_t path_name_id(const char* s, uint32_t len, bool create) {
+    uint32_t b = path_hash(s, len) & (path_name_nbuckets - 1);
+    for (uint32_t id = path_name_buckets[b]; id != PATH_NONE; id = path_name(id)->hash_next) {
+        const char* n = path_name(id)->str;
+        uint32_t i = 0;
+        while (i < len && n[i] == s[i]) i++;
+        if (i == len && n[len] == 0) return id;
+    }
+    if (!create) return PATH_NONE;
+    if ((path_name_count & (PATH_CHUNK - 1)) == 0) {
+        path_name_chunks = (PathName**) path_add_chunk((void**)path_name_chunks, path_name_count, &path_name_cap, sizeof(PathName));
+    }
+    uint32_t id = path_name_count++;
+    path_name(id)->str = path_arena_store(s, len);
+    path_name(id)->hash_next = path_name_buckets[b];
+    path_name_buckets[b] = id;
+    if (path_name_count > path_name_nbuckets * PATH_LOAD) path_grow_names();
+    return id;
+}
+
+static uint32_t path_child(uint32_t parent, uint32_t name, bool create) {
+    uint32_t b = path_pair_hash(parent, name) & (path_entry_nbuckets - 1);
+    for (uint32_t id = path_entry_buckets[b]; id != PATH_NONE; id = path_entry(id)->hash_next) {
+        if (path_entry(id)->parent == parent && path_entry(id)->name == name) return id;
+    }
+    if (!create) return PATH_NONE;
+    if ((path_entry_count & (PATH_CHUNK - 1)) == 0) {
+        path_entry_chunks = (PathEntry**) path_add_chunk((void**)path_entry_chunks, path_entry_count, &path_entry_cap, sizeof(PathEntry));
+    }
+    uint32_t id = path_entry_count++;
+    PathEntry* e = path_entry(id);
+    e->parent = parent;
+    e->name = name;
+    e->hash_next = path_entry_buckets[b];
+    path_entry_buckets[b] = id;
+    if (path_entry_count > path_entry_nbuckets * PATH_LOAD) path_grow_entries();
+    return id;
+}
+
+// 경로 문자열 → ID. '/' 연속이나 끝의 '/' 는 무시, 정규화한 길이가 PATH_MAX_LEN 을 넘으면 PATH_NONE
+static uint32_t path_walk(const char* path, bool create) {
+    if (!path_entry_chunks) path_init();
+    uint32_t id = PATH_ROOT;
+    uint32_t total = 0;
+    const char* p = path;
+    while (*p) {
+        while (*p == '/') p++;
+        if (!*p) break;
+        const char* start = p;
+        while (*p && *p != '/') p++;
+        total += 1 + (uint32_t)(p - start);
+        if (total > PATH_MAX_LEN) return PATH_NONE;
+        uint32_t name = path_name_id(start, (uint32_t)(p - start), create);
+        if (name == PATH_NONE) return PATH_NONE;
+        id = path_child(id, name, create);
+        if (id == PATH_NONE) return PATH_NONE;
+    }
+    return id;
+}
+
+static uint32_t path_intern(const char* path) { return path_walk(path, true); }
+static uint32_t path_find(const char* path) { return path_walk(path, false); }
+static uint32_t path_parent(uint32_t id) { return id == PATH_NONE ? PATH_NONE : path_entry(id)->parent; }
+
+// ID → 경로 문자열 (out 은 PATH_MAX_LEN + 1 바이트, 반환: 길이). path_walk 가 길이를 막으므로 잘리지 않음
+static int path_format(uint32_t id, char* out) {
+    if (id == PATH_ROOT) {
+        out[0] = '/';
+        out[1] = 0;
+        return 1;
+    }
+    // 뒤에서부터 채운 뒤 앞으로 당김
+    char tmp[PATH_MAX_LEN + 1];
+    int pos = PATH_MAX_LEN;
+    tmp[pos] = 0;
+    for (; id != PATH_ROOT && id != PATH_NONE; id = path_entry(id)->parent) {
+        const char* name = path_name(path_entry(id)->name)->str;
+        int len = strlen(name);
+        pos -= len;
+        memcpy(tmp + pos, name, len);
+        tmp[--pos] = '/';
+    }
+    int len = PATH_MAX_LEN - pos;
+    memcpy(out, tmp + pos, len + 1);
+    return len;
+}
+
+// 인터닝 테이블 전체가 차지하는 바이트
+static uint32_t path_table_bytes() {
+    uint32_t name_chunks = (path_name_count + PATH_CHUNK - 1) >> PATH_CHUNK_SHIFT;
+    uint32_t entry_chunks = (path_entry_count + PATH_CHUNK - 1) >> PATH_CHUNK_SHIFT;
+    return path_arena_bytes
+         + name_chunks * PATH_CHUNK * sizeof(PathName) + path_name_cap * sizeof(void*)
+         + entry_chunks * PATH_CHUNK * sizeof(PathEntry) + path_entry_cap * sizeof(void*)
+         + (path_name_nbuckets + path_entry_nbuckets) * sizeof(uint32_t);
+}
+
+#endif // NEUIX_PATH_H
@@ -0,0 +1,80 @@
+// neuix_pci.h – PCI 설정 공간 접근 (메커니즘 #1, 포트 0xCF8/0xCFC)
+
+#ifndef NEUIX_PCI_H
+#define NEUIX_PCI_H
+
+#include "io.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PCI_CONFIG_ADDRESS 0xCF8
+#define PCI_CONFIG_DATA    0xCFC
+
+#define PCI_VENDOR_ID   0x00
+#define PCI_COMMAND     0x04
+#define PCI_CLASS       0x08   // [31:24] class, [23:16] subclass, [15:8] prog-if
+#define PCI_HEADER_TYPE 0x0C   // [23:16] header type (bit 7 = 다기능)
+#define PCI_BAR0        0x10
+#define PCI_BAR5        0x24
+#define PCI_SUBSYSTEM   0x2C   // [31:16] subsystem id
+
+#define PCI_COMMAND_IO          (1 << 0)
+#define PCI_COMMAND_MEMORY      (1 << 1)
+#define PCI_COMMAND_BUS_MASTER  (1 << 2)
+
+typedef struct {
+    uint8_t bus;
+    uint8_t dev;
+    uint8_t func;
+} PciLocation;
+
+static uint32_t pci_read32(PciLocation loc, uint8_t offset) {
+    outl(PCI_CONFIG_ADDRESS, 0x80000000u | ((uint32_t)loc.bus << 16) |
+         ((uint32_t)loc.dev << 11) | ((uint32_t)loc.func << 8) | (offset & 0xFC));
+    return inl(PCI_CONFIG_DATA);
+}
+
+static void pci_write32(PciLocation loc, uint8_t offset, uint32_t val) {
+    outl(PCI_CONFIG_ADDRESS, 0x80000000u | ((uint32_t)loc.bus << 16) |
+         ((uint32_t)loc.dev << 11) | ((uint32_t)loc.func << 8) | (offset & 0xFC));
+    outl(PCI_CONFIG_DATA, val);
+}
+
+// 메모리/IO 디코드와 버스 마스터(DMA) 켜기
+static void pci_enable(PciLocation loc) {
+    uint32_t cmd = pci_read32(loc, PCI_COMMAND);
+    cmd |= PCI_COMMAND_IO | PCI_COMMAND_MEMORY | PCI_COMMAND_BUS_MASTER;
+    pci_write32(loc, PCI_COMMAND, cmd);
+}
+
+// 조건에 맞는 첫 장치 찾기 (값이 0xFFFF 인 항목은 비교하지 않음)
+static bool pci_find(uint16_t vendor, uint16_t device, uint8_t cls, uint8_t subclass, uint16_t progif,
+                     PciLocation* out) {
+    for (uint32_t bus = 0; bus < 256; bus++) {
+        for (uint8_t dev = 0; dev < 32; dev++) {
+            for (uint8_t func = 0; func < 8; func++) {
+                PciLocation loc = { (uint8_t)bus, dev, func };
+                uint32_t id = pci_read32(loc, PCI_VENDOR_ID);
+                if ((id & 0xFFFF) == 0xFFFF) {
+                    if (func == 0) break;
+                    continue;
+                }
+                uint32_t cl = pci_read32(loc, PCI_CLASS);
+                bool match = (vendor == 0xFFFF || (id & 0xFFFF) == vendor) &&
+                             (device == 0xFFFF || (id >> 16) == device) &&
+                             (cls == 0xFF || (cl >> 24) == cls) &&
+                             (subclass == 0xFF || ((cl >> 16) & 0xFF) == subclass) &&
+                             (progif == 0xFFFF || ((cl >> 8) & 0xFF) == progif);
+                if (match) {
+                    *out = loc;
+                    return true;
+                }
+                // 단일 기능 장치면 나머지 function 건너뜀
+                if (func == 0 && !((pci_read32(loc, PCI_HEADER_TYPE) >> 16) & 0x80)) break;
+            }
+        }
+    }
+    return false;
+}
+
+#endif // NEUIX_PCI_H
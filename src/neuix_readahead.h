@@ -0,0 +1,202 @@
+// neuix_readahead.h – 디스크 읽기 캐시 + 파일별 적응형 미리 읽기
+//
+// 디스크를 4KB 청크 단위로 캐시한다. 읽기 스트림(파일 extent)마다 다음 예상 위치를 기억해
+// 순차 접근이면 미리 읽기 창을 두 배로 늘리고, 임의 접근이면 절반으로 줄인다.
+// 창 안의 청크는 block_submit 으로 비동기 제출만 하고, 실제로 읽을 때 block_wait 한다.
+// 섹터 정렬된 큰 읽기는 캐시를 거치지 않고 목적지로 바로 (한 번의 큰 전송).
+// 디스크에 쓰는 쪽은 ra_invalidate 로 겹치는 청크를 버려야 한다.
+
+#ifndef NEUIX_READAHEAD_H
+#define NEUIX_READAHEAD_H
+
+#include "neuix_block.h"
+#include "neuix_mem.h"
+#include "neuix_vga.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RA_CHUNK_SECTORS 8
+#define RA_CHUNK_BYTES   (RA_CHUNK_SECTORS * BLOCK_SECTOR_SIZE)
+#define RA_SLOTS         64                      // 캐시 256KB
+#define RA_MIN_WINDOW    (2 * RA_CHUNK_BYTES)
+#define RA_MAX_WINDOW    (32 * RA_CHUNK_BYTES)   // 캐시의 절반까지만
+#define RA_DIRECT_BYTES  (16 * 1024)             // 이 이상 정렬된 읽기는 캐시 우회
+#define RA_CHUNK_NONE    0xFFFFFFFFFFFFFFFFull
+
+// 읽기 스트림 하나의 접근 패턴 (바이트 단위 디스크 위치)
+typedef struct {
+    uint64_t next;      // 순차라면 다음 읽기가 시작할 위치
+    uint64_t issued;    // 여기까지는 이미 미리 읽기를 제출함
+    uint64_t end;       // 스트림 끝 (이 뒤로는 미리 읽지 않음)
+    uint32_t window;    // 현재 미리 읽기 창 (0 = 끔)
+} ReadaheadState;
+
+typedef struct {
+    uint64_t chunk;     // 청크 번호 (LBA / RA_CHUNK_SECTORS), 비었으면 RA_CHUNK_NONE
+    uint32_t stamp;     // LRU
+    bool inflight;      // 비동기 읽기 진행 중
+    BlockRequest req;
+} RaSlot;
+
+static RaSlot ra_slots[RA_SLOTS];
+static uint8_t ra_data[RA_SLOTS][RA_CHUNK_BYTES] __attribute__((aligned(16)));
+static uint32_t ra_clock = 0;
+static bool ra_ready = false;
+
+// 통계 (쉘 명령 rastat)
+static uint32_t ra_hits = 0;          // 캐시에 있던 청크 (성공한 미리 읽기를 기다린 것 포함)
+static uint32_t ra_misses = 0;        // 동기로 읽어야 했던 청크
+static uint32_t ra_prefetched = 0;    // 미리 읽기로 제출한 청크
+static uint32_t ra_direct = 0;        // 캐시를 우회한 큰 전송 횟수
+
+static void ra_stream_init(ReadaheadState* st, uint64_t start, uint64_t end) {
+    st->next = start;
+    st->issued = start;
+    st->end = end;
+    st->window = 0;
+}
+
+static void ra_init() {
+    for (uint32_t i = 0; i < RA_SLOTS; i++) ra_slots[i].chunk = RA_CHUNK_NONE;
+    ra_ready = true;
+}
+
+static RaSlot* ra_find(uint64_t chunk) {
+    for (uint32_t i = 0; i < RA_SLOTS; i++) {
+        if (ra_slots[i].chunk == chunk) return &ra_slots[i];
+    }
+    return NULL;
+}
+
+// 진행 중이던 읽기가 끝날 때까지 대기 (실패하면 슬롯 비움)
+static void ra_settle(RaSlot* slot) {
+    if (!slot->inflight) return;
+    if (!block_wait(&slot->req)) slot->chunk = RA_CHUNK_NONE;
+    slot->inflight = false;
+}
+
+// 가장 오래 안 쓴 슬롯을 비워 chunk 에 배정
+static RaSlot* ra_alloc(uint64_t chunk) {
+    RaSlot* victim = &ra_slots[0];
+    for (uint32_t i = 0; i < RA_SLOTS; i++) {
+        if (ra_slots[i].chunk == RA_CHUNK_NONE) { victim = &ra_slots[i]; break; }
+        if (ra_slots[i].stamp < victim->stamp) victim = &ra_slots[i];
+    }
+    ra_settle(victim);
+    victim->chunk = chunk;
+    victim->stamp = ++ra_clock;
+    victim->req.lba = chunk * RA_CHUNK_SECTORS;
+    victim->req.count = RA_CHUNK_SECTORS;
+    // 디스크 끝에 걸친 청크는 남은 섹터만
+    if (block_dev->sectors && victim->req.lba + RA_CHUNK_SECTORS > block_dev->sectors) {
+        victim->req.count = (uint32_t)(block_dev->sectors - victim->req.lba);
+    }
+    victim->req.buf = ra_data[victim - ra_slots];
+    victim->req.write = false;
+    return victim;
+}
+
+static bool ra_chunk_on_disk(uint64_t chunk) {
+    return !block_dev->sectors || chunk * RA_CHUNK_SECTORS < block_dev->sectors;
+}
+
+// 청크를 캐시에 올려 반환 (없으면 동기 읽기)
+static RaSlot* ra_get(uint64_t chunk) {
+    RaSlot* slot = ra_find(chunk);
+    if (slot) {
+        ra_settle(slot);
+        if (slot->chunk == chunk) {
+            ra_hits++;
+            slot->stamp = ++ra_clock;
+            return slot;
+        }
+    }
+    // 없거나 미리 읽기가 실패한 청크
+    ra_misses++;
+    slot = ra_alloc(chunk);
+    if (!block_read(slot->req.lba, slot->req.count, slot->req.buf)) {
+        vga_write("[RA] Read error.\n");
+    }
+    return slot;
+}
+
+// 접근 패턴 갱신: 순차면 창 두 배, 아니면 절반 (최소 미만이면 끔)
+static void ra_update_window(ReadaheadState* st, uint64_t pos, uint32_t len) {
+    if (pos == st->next) {
+        st->window = st->window ? st->window * 2 : RA_MIN_WINDOW;
+        if (st->window > RA_MAX_WINDOW) st->window = RA_MAX_WINDOW;
+    } else {
+        st->window /= 2;
+        if (st->window < RA_MIN_WINDOW) st->window = 0;
+        st->issued = pos + len;
+    }
+    st->next = pos + len;
+}
+
+// 스트림에서 pos 앞까지를 읽지 않고 건너뜀: 순차 접근으로 보고 창은 유지
+static void ra_skip(ReadaheadState* st, uint64_t pos) {
+    if (pos > st->next) st->next = pos;
+}
+
+// 창 안에서 아직 제출하지 않은 청크를 비동기로 제출
+static void ra_issue(ReadaheadState* st) {
+    if (!st->window) return;
+    uint64_t limit = st->next + st->window;
+    if (limit > st->end) limit = st->end;
+    uint64_t from = st->issued > st->next ? st->issued : st->next;
+    if (from >= limit) return;
+
+    uint64_t last = (limit - 1) / RA_CHUNK_BYTES;
+    for (uint64_t chunk = from / RA_CHUNK_BYTES; chunk <= last; chunk++) {
+        if (ra_find(chunk) || !ra_chunk_on_disk(chunk)) continue;
+        RaSlot* slot = ra_alloc(chunk);
+        slot->inflight = true;
+        block_submit(&slot->req);
+        ra_prefetched++;
+    }
+    block_flush();   // 읽는 쪽이 기다리기 전에 장치가 시작하도록
+    st->issued = limit;
+}
+
+// 디스크 바이트 위치 pos 부터 len 바이트를 dst 로
+static void ra_read(ReadaheadState* st, uint64_t pos, uint8_t* dst, uint32_t len) {
+    if (!ra_ready) ra_init();
+    if (!len) return;
+    ra_update_window(st, pos, len);
+    while (len) {
+        if (pos % BLOCK_SECTOR_SIZE == 0 && len >= RA_DIRECT_BYTES) {
+            uint32_t count = len / BLOCK_SECTOR_SIZE;
+            if (!block_read(pos / BLOCK_SECTOR_SIZE, count, dst)) vga_write("[RA] Read error.\n");
+            ra_direct++;
+            pos += count * BLOCK_SECTOR_SIZE;
+            dst += count * BLOCK_SECTOR_SIZE;
+            len -= count * BLOCK_SECTOR_SIZE;
+            continue;
+        }
+        uint64_t chunk = pos / RA_CHUNK_BYTES;
+        uint32_t off = (uint32_t)(pos % RA_CHUNK_BYTES);
+        uint32_t n = RA_CHUNK_BYTES - off;
+        if (n > len) n = len;
+        RaSlot* slot = ra_get(chunk);
+        memcpy(dst, slot->req.buf + off, n);
+        pos += n;
+        dst += n;
+        len -= n;
+    }
+    ra_issue(st);
+}
+
+// lba 부터 count 섹터에 걸친 캐시 청크 버리기 (디스크에 쓰기 전에 호출)
+static void ra_invalidate(uint64_t lba, uint32_t count) {
+    if (!ra_ready || !count) return;
+    uint64_t first = lba / RA_CHUNK_SECTORS;
+    uint64_t last = (lba + count - 1) / RA_CHUNK_SECTORS;
+    for (uint32_t i = 0; i < RA_SLOTS; i++) {
+        RaSlot* slot = &ra_slots[i];
+        if (slot->chunk == RA_CHUNK_NONE || slot->chunk < first || slot->chunk > last) continue;
+        ra_settle(slot);
+        slot->chunk = RA_CHUNK_NONE;
+    }
+}
+
+#endif // NEUIX_READAHEAD_H
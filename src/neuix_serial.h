@@ -0,0 +1,36 @@
+// neuix_serial.h – COM1 직렬 포트 출력 (폴링, 115200 8N1)
+
+#ifndef NEUIX_SERIAL_H
+#define NEUIX_SERIAL_H
+
+#include "io.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SERIAL_COM1       0x3F8
+#define SERIAL_LSR_THRE   (1 << 5)   // 송신 버퍼 빔
+
+static bool serial_ready = false;
+
+static void serial_init() {
+    outb(SERIAL_COM1 + 1, 0x00);   // 인터럽트 끔
+    outb(SERIAL_COM1 + 3, 0x80);   // DLAB
+    outb(SERIAL_COM1 + 0, 0x01);   // 분주 1 = 115200
+    outb(SERIAL_COM1 + 1, 0x00);
+    outb(SERIAL_COM1 + 3, 0x03);   // 8N1
+    outb(SERIAL_COM1 + 2, 0xC7);   // FIFO 사용, 비움
+    outb(SERIAL_COM1 + 4, 0x03);   // DTR, RTS
+    serial_ready = true;
+}
+
+static void serial_putc(char c) {
+    if (!serial_ready) serial_init();
+    while (!(inb(SERIAL_COM1 + 5) & SERIAL_LSR_THRE));
+    outb(SERIAL_COM1, (uint8_t)c);
+}
+
+static void serial_write(const char* s) {
+    while (*s) serial_putc(*s++);
+}
+
+#endif // NEUIX_SERIAL_H
@@ -0,0 +1,264 @@
+// neuix_syscall.h – Neuix OS 시스템 콜 / 바이너리 실행
+//
+// ABI (i386): EAX = 번호, EBX/ECX/EDX/ESI/EDI = 인자 1~5, 반환값 EAX.
+// EAX 외의 레지스터는 보존된다.
+//   - int 0x80 : 항상 사용 가능한 게이트
+//   - 빠른 경로: 프로그램 진입 시 첫 번째 인자(cdecl)로 받는 syscall_fast_entry 를
+//     같은 레지스터 규약으로 call 한다. 바이너리는 ring 0 에서 실행되고 GDT 에
+//     유저 세그먼트가 없어서 sysenter/sysexit(항상 CPL3 로 복귀) 는 쓸 수 없다.
+// 번호는 고정이며 새 기능은 끝에만 추가한다 (src/user/neuix_sys.h 와 맞출 것).
+
+#ifndef NEUIX_SYSCALL_H
+#define NEUIX_SYSCALL_H
+
+#include "io.h"
+#include "neuix_mem.h"
+#include "neuix_vga.h"
+#include "neuix_keyboard.h"
+#include "neuix_fs.h"
+#include "neuix_trace.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SYSCALL_VECTOR 0x80
+#define BINARY_LOAD_ADDR 0x100000
+
+#define SYS_NOP       0
+#define SYS_EXIT      1   // (code)
+#define SYS_WRITE     2   // (buf, len) -> len
+#define SYS_GETLINE   3   // (buf, max) -> len
+#define SYS_OPEN      4   // (path, flags) -> fd / -1
+#define SYS_CLOSE     5   // (fd)
+#define SYS_READ_AT   6   // (fd, offset, buf, len) -> 읽은 바이트
+#define SYS_WRITE_AT  7   // (fd, offset, buf, len) -> 쓴 바이트
+#define SYS_APPEND    8   // (fd, buf, len) -> 쓴 바이트
+#define SYS_TRUNCATE  9   // (fd, size) -> 1 / 0
+#define SYS_SIZE      10  // (fd) -> 크기
+#define SYS_TIME      11  // (uint64_t* out) TSC
+#define SYS_COUNT     12
+
+// 바이너리 실행용 타입 (인자: 빠른 시스템 콜 진입점)
+typedef int32_t (*syscall_fast_fn)(void);
+typedef void (*binary_entry_t)(syscall_fast_fn);
+
+// 아래 어셈블리에서 참조하므로 static 이 아님
+uint32_t syscall_saved_esp;
+int32_t syscall_dispatch(uint32_t num, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4, uint32_t a5);
+extern void syscall_int80_entry(void);
+extern int32_t syscall_fast_entry(void);
+extern int32_t syscall_enter_binary(binary_entry_t entry);
+
+__asm__ (
+    ".text\n"
+    // int 0x80: 보존할 레지스터 저장 → 인자 복사본 push → 디스패치
+    ".global syscall_int80_entry\n"
+    "syscall_int80_entry:\n"
+    "    pushl %ebp\n    pushl %edi\n    pushl %esi\n    pushl %edx\n    pushl %ecx\n    pushl %ebx\n"
+    "    pushl %edi\n    pushl %esi\n    pushl %edx\n    pushl %ecx\n    pushl %ebx\n    pushl %eax\n"
+    "    cld\n"
+    "    call syscall_dispatch\n"
+    "    addl $24, %esp\n"
+    "    popl %ebx\n    popl %ecx\n    popl %edx\n    popl %esi\n    popl %edi\n    popl %ebp\n"
+    "    iret\n"
+
+    // 빠른 경로: 동일하되 near call/ret
+    ".global syscall_fast_entry\n"
+    "syscall_fast_entry:\n"
+    "    pushl %ebp\n    pushl %edi\n    pushl %esi\n    pushl %edx\n    pushl %ecx\n    pushl %ebx\n"
+    "    pushl %edi\n    pushl %esi\n    pushl %edx\n    pushl %ecx\n    pushl %ebx\n    pushl %eax\n"
+    "    cld\n"
+    "    call syscall_dispatch\n"
+    "    addl $24, %esp\n"
+    "    popl %ebx\n    popl %ecx\n    popl %edx\n    popl %esi\n    popl %edi\n    popl %ebp\n"
+    "    ret\n"
+
+    // 바이너리 진입: 스택 저장 후 entry(syscall_fast_entry) 호출.
+    // SYS_EXIT 는 syscall_exit_path 로 바로 돌아온다 (EAX = 종료 코드).
+    ".global syscall_enter_binary\n"
+    "syscall_enter_binary:\n"
+    "    pushl %ebp\n    pushl %ebx\n    pushl %esi\n    pushl %edi\n"
+    "    movl %esp, syscall_saved_esp\n"
+    "    movl 20(%esp), %eax\n"
+    "    pushl $syscall_fast_entry\n"
+    "    call *%eax\n"
+    "    xorl %eax, %eax\n"
+    "syscall_exit_path:\n"
+    "    movl syscall_saved_esp, %esp\n"
+    "    popl %edi\n    popl %esi\n    popl %ebx\n    popl %ebp\n"
+    "    ret\n"
+);
+
+static bool binary_running = false;
+static uint32_t binary_open_fds = 0;   // 실행 중인 바이너리가 열어 둔 핸들 (비트 = fd)
+
+static int32_t syscall_handle(uint32_t num, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4, uint32_t a5) {
+    (void)a5;
+    switch (num) {
+        case SYS_NOP:
+            return 0;
+        case SYS_EXIT:
+            if (!binary_running) return -1;
+            TRACE_END(TRACE_CAT_IRQ, TRACE_EV_SYSCALL, a1);
+            __asm__ volatile ("jmp syscall_exit_path" : : "a"(a1));
+            __builtin_unreachable();
+        case SYS_WRITE: {
+            const char* buf = (const char*)a1;
+            for (uint32_t i = 0; i < a2; i++) vga_put_char(buf[i]);
+            return (int32_t)a2;
+        }
+        case SYS_GETLINE:
+            if ((int32_t)a2 <= 0) return 0;
+            getline((char*)a1, (int)a2);
+            return strlen((const char*)a1);
+        case SYS_OPEN: {
+            int fd = fs_open((const char*)a1, a2);
+            if (fd >= 0 && binary_running) binary_open_fds |= 1u << fd;
+            return fd;
+        }
+        case SYS_CLOSE:
+            if (a1 < FS_MAX_OPEN_FILES) binary_open_fds &= ~(1u << a1);
+            fs_close((int)a1);
+            return 0;
+        case SYS_READ_AT:
+            return (int32_t)fs_read_at((int)a1, a2, (uint8_t*)a3, a4);
+        case SYS_WRITE_AT:
+            return (int32_t)fs_write_at((int)a1, a2, (const uint8_t*)a3, a4);
+        case SYS_APPEND:
+            return (int32_t)fs_append((int)a1, (const uint8_t*)a2, a3);
+        case SYS_TRUNCATE:
+            return fs_truncate((int)a1, a2) ? 1 : 0;
+        case SYS_SIZE:
+            return (int32_t)fs_size((int)a1);
+        case SYS_TIME:
+            *(uint64_t*)a1 = rdtsc();
+            return 0;
+    }
+    return -1;
+}
+
+// 두 진입 경로(int 0x80, 빠른 call) 공통: 진입·복귀를 추적 (arg = 번호 / 반환값)
+int32_t syscall_dispatch(uint32_t num, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4, uint32_t a5) {
+    TRACE_BEGIN(TRACE_CAT_IRQ, TRACE_EV_SYSCALL, num);
+    int32_t ret = syscall_handle(num, a1, a2, a3, a4, a5);
+    TRACE_END(TRACE_CAT_IRQ, TRACE_EV_SYSCALL, ret);
+    return ret;
+}
+
+// IDT 게이트 (i386)
+typedef struct {
+    uint16_t offset_low;
+    uint16_t selector;
+    uint8_t  zero;
+    uint8_t  type_attr;
+    uint16_t offset_high;
+} __attribute__((packed)) IdtGate;
+
+typedef struct {
+    uint16_t limit;
+    uint32_t base;
+} __attribute__((packed)) IdtPointer;
+
+static IdtGate syscall_idt[256] __attribute__((aligned(8)));
+
+// 현재 IDT 의 0x80 번에 트랩 게이트(DPL 3, IF 유지) 설치.
+// 부트 코드의 IDT 가 0x80 을 덮지 못하면 기존 항목을 복사한 256칸 테이블로 교체.
+static void syscall_init() {
+    IdtPointer idtr;
+    __asm__ volatile ("sidt %0" : "=m"(idtr));
+    uint16_t cs;
+    __asm__ volatile ("mov %%cs, %0" : "=r"(cs));
+
+    IdtGate* idt = (IdtGate*)idtr.base;
+    if (!idtr.base || idtr.limit < (SYSCALL_VECTOR + 1) * sizeof(IdtGate) - 1) {
+        if (idtr.base) memcpy(syscall_idt, idt, idtr.limit + 1);
+        idt = syscall_idt;
+        idtr.base = (uint32_t)syscall_idt;
+        idtr.limit = sizeof(syscall_idt) - 1;
+        __asm__ volatile ("lidt %0" : : "m"(idtr));
+    }
+
+    uint32_t handler = (uint32_t)syscall_int80_entry;
+    idt[SYSCALL_VECTOR].offset_low = handler & 0xFFFF;
+    idt[SYSCALL_VECTOR].selector = cs;
+    idt[SYSCALL_VECTOR].zero = 0;
+    idt[SYSCALL_VECTOR].type_attr = 0xEF;  // present, DPL 3, 32-bit trap gate
+    idt[SYSCALL_VECTOR].offset_high = (handler >> 16) & 0xFFFF;
+}
+
+// 바이너리 파일 실행 함수: 실행 주소로 바로 읽어 들임 (큰 전송 몇 번, 중간 버퍼 없음)
+static bool run_binary(const char* path) {
+    int fd = fs_open(path, FS_O_READ);
+    if (fd < 0) return false;
+    uint8_t* target = (uint8_t*)BINARY_LOAD_ADDR;
+    fs_read_at(fd, 0, target, fs_size(fd));
+    fs_close(fd);
+
+    extern volatile bool esc_pressed;
+    esc_pressed = false;
+
+    __asm__ volatile ("sti");
+
+    binary_running = true;
+    binary_open_fds = 0;
+    syscall_enter_binary((binary_entry_t)target);
+    binary_running = false;
+
+    __asm__ volatile ("cli");
+
+    // 닫지 않고 끝난 핸들 정리 (쓴 내용은 fs_close 에서 디스크에 반영)
+    for (int fd = 0; fd < FS_MAX_OPEN_FILES; fd++) {
+        if (binary_open_fds & (1u << fd)) fs_close(fd);
+    }
+    binary_open_fds = 0;
+
+    vga_set_color(COLOR_LIGHT_GREEN, COLOR_BLACK);
+    vga_write("\n[Exited binary program]\n");
+    return true;
+}
+
+// 시스템 콜 왕복 지연 측정 (쉘 명령 sysbench)
+#define SYSBENCH_ITERS 100000
+
+static void sysbench_write_num(uint32_t v) {
+    char rev[16];
+    int ri = 0;
+    if (v == 0) rev[ri++] = '0';
+    while (v) {
+        rev[ri++] = '0' + (v % 10);
+        v /= 10;
+    }
+    while (ri) vga_put_char(rev[--ri]);
+}
+
+static void sysbench_run() {
+    uint64_t t0 = rdtsc();
+    for (uint32_t i = 0; i < SYSBENCH_ITERS; i++) {
+        syscall_dispatch(SYS_NOP, 0, 0, 0, 0, 0);
+        __asm__ volatile ("" : : : "memory");
+    }
+    uint32_t direct = (uint32_t)udiv64_32(rdtsc() - t0, SYSBENCH_ITERS, NULL);
+
+    t0 = rdtsc();
+    for (uint32_t i = 0; i < SYSBENCH_ITERS; i++) {
+        int32_t ret;
+        __asm__ volatile ("call syscall_fast_entry" : "=a"(ret) : "a"(SYS_NOP) : "memory");
+    }
+    uint32_t fast = (uint32_t)udiv64_32(rdtsc() - t0, SYSBENCH_ITERS, NULL);
+
+    t0 = rdtsc();
+    for (uint32_t i = 0; i < SYSBENCH_ITERS; i++) {
+        int32_t ret;
+        __asm__ volatile ("int $0x80" : "=a"(ret) : "a"(SYS_NOP) : "memory");
+    }
+    uint32_t gate = (uint32_t)udiv64_32(rdtsc() - t0, SYSBENCH_ITERS, NULL);
+
+    vga_write("SYS_NOP round trip (cycles): direct ");
+    sysbench_write_num(direct);
+    vga_write(", fast call ");
+    sysbench_write_num(fast);
+    vga_write(", int 0x80 ");
+    sysbench_write_num(gate);
+    vga_write("\n");
+}
+
+#endif // NEUIX_SYSCALL_H
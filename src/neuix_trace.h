@@ -0,0 +1,160 @@
+// neuix_trace.h – 커널 이벤트 추적 (고정 크기 레코드 링 버퍼, 직렬 포트로 덤프)
+//
+// TRACE_BEGIN/TRACE_END/TRACE_MARK 는 카테고리가 꺼져 있으면 전역 마스크 한 번 검사뿐이다.
+// 켜져 있으면 TSC 와 함께 16바이트 레코드를 현재 CPU 의 링에 기록한다.
+// 슬롯은 lock xadd 로 예약하므로 인터럽트 안에서 기록해도 잠금이 필요 없다.
+// 링이 차면 오래된 레코드부터 덮는다.
+//
+// 덤프 형식: 한 줄에 Chrome trace 이벤트 하나 (JSON Lines, ts 는 TSC 사이클).
+// 호스트에서 `jq -s '{traceEvents: .}' trace.log > trace.json` 으로 감싸면
+// chrome://tracing / Perfetto 에서 열 수 있다 (마이크로초로 보려면 ts 를 MHz 로 나눔).
+
+#ifndef NEUIX_TRACE_H
+#define NEUIX_TRACE_H
+
+#include "io.h"
+#include "neuix_mem.h"
+#include "neuix_serial.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TRACE_MAX_CPUS    1       // SMP 가 생기면 CPU 번호로 링을 고름
+#define TRACE_RING_SIZE   4096    // CPU 당 레코드 수 (2의 거듭제곱)
+
+// 카테고리 (비트 마스크)
+#define TRACE_CAT_BLOCK   (1 << 0)   // 블록 계층, ATA 드라이버
+#define TRACE_CAT_FS      (1 << 1)   // 파일시스템 연산
+#define TRACE_CAT_IRQ     (1 << 2)   // 인터럽트/시스템 콜 진입·복귀
+#define TRACE_CAT_SHELL   (1 << 3)   // 쉘 명령 실행
+#define TRACE_CAT_ALL     0x0F
+
+// 이벤트 번호 (trace_event_names 와 순서를 맞출 것)
+enum {
+    TRACE_EV_BLOCK_READ,
+    TRACE_EV_BLOCK_WRITE,
+    TRACE_EV_ATA_READ,
+    TRACE_EV_ATA_WRITE,
+    TRACE_EV_FS_INIT,
+    TRACE_EV_FS_SAVE,
+    TRACE_EV_FS_OPEN,
+    TRACE_EV_FS_READ_AT,
+    TRACE_EV_FS_WRITE_AT,
+    TRACE_EV_FS_CLOSE,
+    TRACE_EV_FS_CREATE,
+    TRACE_EV_FS_DELETE,
+    TRACE_EV_FS_MOVE,
+    TRACE_EV_SYSCALL,
+    TRACE_EV_IRQ_KEYBOARD,
+    TRACE_EV_SHELL_CMD,
+    TRACE_EV_COUNT
+};
+
+static const char* const trace_event_names[TRACE_EV_COUNT] = {
+    "block_read", "block_write", "ata_read", "ata_write",
+    "fs_init", "fs_save", "fs_open", "fs_read_at", "fs_write_at", "fs_close",
+    "fs_create", "fs_delete", "fs_move",
+    "syscall", "irq_keyboard", "shell_cmd",
+};
+
+static const char* const trace_cat_names[] = { "block", "fs", "irq", "shell" };
+
+typedef struct {
+    uint64_t tsc;
+    uint16_t event;
+    uint8_t cat;      // 카테고리 비트 번호
+    char phase;       // 'B' 시작, 'E' 끝, 'i' 순간
+    uint32_t arg;
+} __attribute__((packed)) TraceRecord;
+
+typedef struct {
+    volatile uint32_t head;   // 지금까지 예약된 레코드 수 (링 위치 = head % 크기)
+    TraceRecord ring[TRACE_RING_SIZE];
+} TraceBuffer;
+
+static volatile uint32_t trace_mask = 0;
+static TraceBuffer trace_cpus[TRACE_MAX_CPUS];
+
+static inline uint32_t trace_cpu() { return 0; }
+
+static uint8_t trace_cat_index(uint32_t cat) {
+    uint8_t i = 0;
+    while (cat > 1) { cat >>= 1; i++; }
+    return i;
+}
+
+static void trace_emit(uint32_t cat, uint16_t event, char phase, uint32_t arg) {
+    TraceBuffer* tb = &trace_cpus[trace_cpu()];
+    uint32_t slot = __atomic_fetch_add(&tb->head, 1, __ATOMIC_RELAXED) & (TRACE_RING_SIZE - 1);
+    TraceRecord* r = &tb->ring[slot];
+    r->tsc = rdtsc();
+    r->event = event;
+    r->cat = trace_cat_index(cat);
+    r->phase = phase;
+    r->arg = arg;
+}
+
+#define TRACE_EMIT(cat, ev, ph, arg) \
+    do { if (__builtin_expect(trace_mask & (cat), 0)) trace_emit((cat), (ev), (ph), (uint32_t)(arg)); } while (0)
+#define TRACE_BEGIN(cat, ev, arg) TRACE_EMIT(cat, ev, 'B', arg)
+#define TRACE_END(cat, ev, arg)   TRACE_EMIT(cat, ev, 'E', arg)
+#define TRACE_MARK(cat, ev, arg)  TRACE_EMIT(cat, ev, 'i', arg)
+
+static void trace_clear() {
+    for (uint32_t c = 0; c < TRACE_MAX_CPUS; c++) trace_cpus[c].head = 0;
+}
+
+// 카테고리 이름 → 비트 ("all" 포함, 없으면 0)
+static uint32_t trace_parse_cat(const char* name) {
+    if (streq(name, "all")) return TRACE_CAT_ALL;
+    for (uint32_t i = 0; i < sizeof(trace_cat_names) / sizeof(trace_cat_names[0]); i++) {
+        if (streq(name, trace_cat_names[i])) return 1u << i;
+    }
+    return 0;
+}
+
+// uint64 를 10진수로
+static void trace_serial_u64(uint64_t v) {
+    char rev[24];
+    int ri = 0;
+    do {
+        uint32_t rem;
+        v = udiv64_32(v, 10, &rem);
+        rev[ri++] = '0' + rem;
+    } while (v);
+    while (ri) serial_putc(rev[--ri]);
+}
+
+// 기록된 레코드를 오래된 것부터 직렬 포트로 (덤프 중에는 추적을 멈춤)
+static uint32_t trace_dump() {
+    uint32_t saved = trace_mask;
+    trace_mask = 0;
+    uint32_t total = 0;
+    serial_write("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"neuix (ts = TSC cycles)\"}}\n");
+    for (uint32_t c = 0; c < TRACE_MAX_CPUS; c++) {
+        TraceBuffer* tb = &trace_cpus[c];
+        uint32_t head = tb->head;
+        uint32_t count = head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE;
+        for (uint32_t i = head - count; i != head; i++) {
+            TraceRecord* r = &tb->ring[i & (TRACE_RING_SIZE - 1)];
+            char ph[2] = { r->phase, 0 };
+            serial_write("{\"name\":\"");
+            serial_write(r->event < TRACE_EV_COUNT ? trace_event_names[r->event] : "?");
+            serial_write("\",\"cat\":\"");
+            serial_write(trace_cat_names[r->cat]);
+            serial_write("\",\"ph\":\"");
+            serial_write(ph);
+            serial_write(r->phase == 'i' ? "\",\"s\":\"t\",\"ts\":" : "\",\"ts\":");
+            trace_serial_u64(r->tsc);
+            serial_write(",\"pid\":0,\"tid\":");
+            trace_serial_u64(c);
+            serial_write(",\"args\":{\"arg\":");
+            trace_serial_u64(r->arg);
+            serial_write("}}\n");
+            total++;
+        }
+    }
+    trace_mask = saved;
+    return total;
+}
+
+#endif // NEUIX_TRACE_H
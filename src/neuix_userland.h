@@ -4,26 +4,47 @@
 #include "neuix_keyboard.h"
 #include "neuix_vga.h"
 #include "neuix_fs.h"
+#include "neuix_syscall.h"
+#include "neuix_membench.h"
+#include "neuix_trace.h"
 #include <stdint.h>
 #include <stdbool.h>
 
 static char cwd[256] = "/root";
 
-static bool startswith(const char* str, const char* prefix) {
-    while (*prefix) {
-        if (*str++ != *prefix++) return false;
+// 절대 경로로 만들고 ".", "..", 빈 구성요소 정리.
+// 어느 마운트(디스크/tmpfs)가 맡을지는 이 결과의 경로 접두사로 정해진다.
+static void make_path(const char* input, char* output) {
+    char full[512];
+    int n = 0;
+    if (input[0] != '/') {
+        for (const char* c = cwd; *c && n < 510; c++) full[n++] = *c;
+        full[n++] = '/';
     }
-    return true;
-}
+    for (const char* c = input; *c && n < 511; c++) full[n++] = *c;
+    full[n] = 0;
 
-static void make_path(const char* input, char* output) {
-    if (input[0] == '/') {
-        strcpy(output, input);
-    } else {
-        strcpy(output, cwd);
-        strcat(output, "/");
-        strcat(output, input);
+    int out = 0;
+    char* p = full;
+    while (*p) {
+        while (*p == '/') p++;
+        if (!*p) break;
+        char* start = p;
+        while (*p && *p != '/') p++;
+        int len = (int)(p - start);
+        if (len == 1 && start[0] == '.') continue;
+        if (len == 2 && start[0] == '.' && start[1] == '.') {
+            while (out > 0 && output[out - 1] != '/') out--;
+            if (out > 0) out--;
+            continue;
+        }
+        if (out + 1 + len > 255) break;
+        output[out++] = '/';
+        memcpy(output + out, start, len);
+        out += len;
     }
+    if (out == 0) output[out++] = '/';
+    output[out] = 0;
 }
 
 static void login() {
@@ -76,202 +97,690 @@ static void login() {
     }
 }
 
-static void userland() {
-    while (1) {
-        vga_write(cwd);
-        vga_write("> ");
+// ---- 쉘 입출력: 파이프 버퍼 / 스크립트 입력 ----
 
-        char cmdline[256];
-        getline(cmdline, 256);
+#define SH_MAX_STAGES 8
+#define SH_MAX_DEPTH  8
+#define SH_AUTORUN_PATH "/root/autorun.sh"
 
-        if (strcmp(cmdline, "ls") == 0) {
-            FileNode* node = fs_root;
-            while (node) {
-                vga_write(node->path);
-                vga_write(" [");
-                vga_write(type_to_str(node->type));
-                vga_write("] ");
-                char sizebuf[16];
-                int si = 0;
-                uint32_t temp = node->size;
-                char rev[16];
-                int ri = 0;
-                if (temp == 0) rev[ri++] = '0';
-                while (temp) {
-                    rev[ri++] = '0' + (temp % 10);
-                    temp /= 10;
-                }
-                for (int i = ri-1; i >= 0; i--) sizebuf[si++] = rev[i];
-                sizebuf[si] = 0;
-                vga_write(sizebuf);
-                vga_write(" bytes\n");
-                node = node->next;
-            }
-        }
-        else if (strcmp(cmdline, "help") == 0) {
-            vga_write("Commands:\n");
-            vga_write("ls, format, cat <file>, touch <file>, mkdir <dir>, rm <path>, mv <old> <new>, cp <src> <dst>, cd <dir>, cd .., run <bin>, ed <file>, stat <file>, help\n");
+// 메모리 파이프 (앞 단계 출력을 모아 두었다가 다음 단계가 읽음)
+typedef struct {
+    uint8_t* data;
+    uint32_t len;
+    uint32_t cap;
+    uint32_t rpos;
+} PipeBuffer;
+
+static PipeBuffer* sh_stdout = NULL;  // NULL 이면 화면
+static PipeBuffer* sh_stdin = NULL;   // NULL 이면 스크립트/키보드
+
+// 실행 중인 스크립트 (sh 중첩)
+typedef struct {
+    int fd;
+    uint32_t offset;
+} ShScript;
+
+static ShScript sh_scripts[SH_MAX_DEPTH];
+static int sh_depth = 0;
+
+static void pipe_write(PipeBuffer* p, const char* s, uint32_t n) {
+    if (p->len + n > p->cap) {
+        uint32_t cap = p->cap ? p->cap : 512;
+        while (cap < p->len + n) cap *= 2;
+        uint8_t* data = (uint8_t*) malloc(cap);
+        memcpy(data, p->data, p->len);
+        if (p->data) free(p->data);
+        p->data = data;
+        p->cap = cap;
+    }
+    memcpy(p->data + p->len, s, n);
+    p->len += n;
+}
+
+static void sh_out_n(const char* s, uint32_t n) {
+    if (sh_stdout) {
+        pipe_write(sh_stdout, s, n);
+    } else {
+        for (uint32_t i = 0; i < n; i++) vga_put_char(s[i]);
+    }
+}
+
+static void sh_out(const char* s) {
+    if (sh_stdout) pipe_write(sh_stdout, s, strlen(s));
+    else vga_write(s);
+}
+
+static void sh_out_num(uint32_t temp) {
+    char rev[16];
+    char sizebuf[16];
+    int ri = 0, si = 0;
+    if (temp == 0) rev[ri++] = '0';
+    while (temp) {
+        rev[ri++] = '0' + (temp % 10);
+        temp /= 10;
+    }
+    for (int i = ri-1; i >= 0; i--) sizebuf[si++] = rev[i];
+    sizebuf[si] = 0;
+    sh_out(sizebuf);
+}
+
+static void sh_out_u64(uint64_t v) {
+    char rev[24];
+    char numbuf[24];
+    int ri = 0, si = 0;
+    do {
+        uint32_t digit;
+        v = udiv64_32(v, 10, &digit);
+        rev[ri++] = '0' + digit;
+    } while (v);
+    while (ri) numbuf[si++] = rev[--ri];
+    numbuf[si] = 0;
+    sh_out(numbuf);
+}
+
+// buf 에서 한 줄 잘라내기 (반환: 소비한 바이트 수)
+static uint32_t sh_take_line(const uint8_t* buf, uint32_t n, char* out, int max) {
+    uint32_t i = 0;
+    int len = 0;
+    while (i < n && buf[i] != '\n') {
+        if (len < max - 1) out[len++] = buf[i];
+        i++;
+    }
+    out[len] = 0;
+    return i < n ? i + 1 : i;
+}
+
+// 한 줄 입력: 파이프 → 스크립트 → 키보드 순서 (false 면 입력 끝)
+static bool sh_getline(char* out, int max) {
+    if (sh_stdin) {
+        if (sh_stdin->rpos >= sh_stdin->len) return false;
+        sh_stdin->rpos += sh_take_line(sh_stdin->data + sh_stdin->rpos,
+                                       sh_stdin->len - sh_stdin->rpos, out, max);
+        return true;
+    }
+    if (sh_depth > 0) {
+        ShScript* sc = &sh_scripts[sh_depth - 1];
+        uint8_t buf[256];
+        uint32_t n = fs_read_at(sc->fd, sc->offset, buf, sizeof(buf));
+        if (n == 0) return false;
+        uint32_t used = sh_take_line(buf, n, out, max);
+        sc->offset += used;
+        // 한 줄이 버퍼보다 길면 나머지는 버림
+        while (used == n && buf[n - 1] != '\n') {
+            n = fs_read_at(sc->fd, sc->offset, buf, sizeof(buf));
+            if (n == 0) break;
+            char skip[1];
+            used = sh_take_line(buf, n, skip, 1);
+            sc->offset += used;
         }
-        else if (strcmp(cmdline, "format") == 0) {
-            FileNode* node = fs_root;
-            while (node) {
-                FileNode* next = node->next;
-                if (node->content) free(node->content);
-                free(node);
-                node = next;
-            }
-            fs_root = NULL;
-            fs_save();
-            fs_create("/root", TYPE_DIR, NULL, 0);
-            vga_write("[Disk formatted]\n");
+        return true;
+    }
+    getline(out, max);
+    return true;
+}
+
+static bool sh_interactive() { return !sh_stdin && sh_depth == 0; }
+
+static void sh_exec_line(const char* line);
+
+// ---- 명령 ----
+
+static void cmd_help(const char* args);
+
+static void cmd_ls(const char* args) {
+    (void)args;
+    char path[PATH_MAX_LEN + 1];
+    for (uint8_t m = 0; m < fs_mount_count; m++) {
+        for (FileNode* node = *fs_mount_list(m); node; node = node->next) {
+            if (fs_node_shadowed(node, m)) continue;
+            path_format(node->path_id, path);
+            sh_out(path);
+            sh_out(" [");
+            sh_out(type_to_str(node->type));
+            sh_out("] ");
+            sh_out_num(node->size);
+            sh_out(" bytes\n");
         }
-        else if (startswith(cmdline, "cat ")) {
-            char path[256];
-            make_path(cmdline + 4, path);
-            uint8_t buf[4096];
-            uint32_t size;
-            if (fs_read(path, buf, &size)) {
-                buf[size] = 0;
-                vga_write((char*)buf);
-                vga_write("\n");
-            } else {
-                vga_write("[Not Found]\n");
+    }
+}
+
+// mount                        : 마운트 목록
+// mount tmpfs <path> [bytes]   : 메모리 전용 마운트 (한도 생략 시 기본값, 0 = 무제한)
+static void cmd_mount(const char* args) {
+    if (!*args) {
+        char path[PATH_MAX_LEN + 1];
+        for (uint32_t m = 0; m < fs_mount_count; m++) {
+            path_format(fs_mounts[m].path_id, path);
+            sh_out(path);
+            if (fs_mounts[m].type == MOUNT_DISK) {
+                sh_out(" disk (");
+                sh_out(block_dev->name);
+                sh_out(")\n");
+                continue;
             }
+            sh_out(" tmpfs ");
+            sh_out_num(fs_mounts[m].used);
+            sh_out("/");
+            if (fs_mounts[m].limit) sh_out_num(fs_mounts[m].limit);
+            else sh_out("unlimited");
+            sh_out(" bytes\n");
         }
-        else if (startswith(cmdline, "ed ")) {
-            char path[256];
-            make_path(cmdline + 3, path);
-            vga_write("Enter new content. End with a single line containing only '.':\n");
-            uint8_t newcontent[4096];
-            int idx = 0;
-            while (1) {
-                char line[256];
-                getline(line, 256);
-                if (strcmp(line, ".") == 0) break;
-                int len = strlen(line);
-                for (int i = 0; i < len; i++) newcontent[idx++] = line[i];
-                newcontent[idx++] = '\n';
-            }
-            fs_create(path, TYPE_FILE, newcontent, idx);
-            vga_write("[File edited]\n");
+        return;
+    }
+    char type[16], word[256], target[256];
+    int i = 0;
+    while (*args && *args != ' ' && i < 15) type[i++] = *args++;
+    type[i] = 0;
+    while (*args == ' ') args++;
+    i = 0;
+    while (*args && *args != ' ' && i < 255) word[i++] = *args++;
+    word[i] = 0;
+    while (*args == ' ') args++;
+    make_path(word, target);
+    uint32_t limit = FS_TMPFS_DEFAULT_MAX;
+    if (*args) {
+        limit = 0;
+        for (; *args >= '0' && *args <= '9'; args++) limit = limit * 10 + (*args - '0');
+    }
+    if (!streq(type, "tmpfs")) {
+        sh_out("Usage: mount [tmpfs <path> [bytes]]\n");
+    } else if (fs_mount_tmpfs(target, limit)) {
+        sh_out("[Mounted]\n");
+    } else {
+        sh_out("[Mount Failed]\n");
+    }
+}
+
+static void cmd_umount(const char* args) {
+    char path[256];
+    make_path(args, path);
+    sh_out(fs_unmount(path) ? "[Unmounted]\n" : "[Unmount Failed]\n");
+}
+
+static void cmd_membench(const char* args) { (void)args; membench_run(); }
+static void cmd_sysbench(const char* args) { (void)args; sysbench_run(); }
+
+// 파일 메타데이터 메모리 (노드 풀 + 공유 extent 구조체 + 경로 인터닝 테이블, 내용 제외)
+static void cmd_fsmem(const char* args) {
+    (void)args;
+    uint32_t files = 0, ext_bytes = 0;
+    for (uint8_t m = 0; m < fs_mount_count; m++) {
+        for (FileNode* node = *fs_mount_list(m); node; node = node->next) {
+            files++;
+            if (node->shared) ext_bytes += sizeof(FileExtent) / node->share.extent->refcount;
         }
-        else if (startswith(cmdline, "stat ")) {
-            char path[256];
-            make_path(cmdline + 5, path);
-            FileNode* node = fs_root;
-            while (node) {
-                if (streq(node->path, path)) {
-                    vga_write("Path: "); vga_write(node->path); vga_write("\n");
-                    vga_write("Type: "); vga_write(type_to_str(node->type)); vga_write("\n");
-                    vga_write("Size: ");
-                    char sizebuf[16];
-                    int si = 0;
-                    uint32_t temp = node->size;
-                    char rev[16];
-                    int ri = 0;
-                    if (temp == 0) rev[ri++] = '0';
-                    while (temp) {
-                        rev[ri++] = '0' + (temp % 10);
-                        temp /= 10;
-                    }
-                    for (int i = ri-1; i >= 0; i--) sizebuf[si++] = rev[i];
-                    sizebuf[si] = 0;
-                    vga_write(sizebuf);
-                    vga_write(" bytes\n");
-                    break;
-                }
-                node = node->next;
+    }
+    uint32_t node_bytes = fs_node_blocks * FS_NODE_BLOCK * sizeof(FileNode);
+    uint32_t path_bytes = path_table_bytes();
+    sh_out("Files: ");
+    sh_out_num(files);
+    sh_out("\nNodes: ");
+    sh_out_num(node_bytes);
+    sh_out(" bytes, extents: ");
+    sh_out_num(ext_bytes);
+    sh_out(" bytes, paths: ");
+    sh_out_num(path_bytes);
+    sh_out(" bytes\nPer file: ");
+    sh_out_num(files ? (node_bytes + ext_bytes + path_bytes) / files : 0);
+    sh_out(" bytes\n");
+}
+
+// 추적: trace [on|off <cat...>] | clear | dump  (cat: block fs irq shell all)
+static void cmd_trace(const char* args) {
+    char buf[128];
+    int len = 0;
+    while (args[len] && len < 127) { buf[len] = args[len]; len++; }
+    buf[len] = 0;
+
+    char* word = buf;
+    char* rest = buf;
+    while (*rest && *rest != ' ') rest++;
+    if (*rest) *rest++ = 0;
+
+    if (streq(word, "on") || streq(word, "off")) {
+        bool on = streq(word, "on");
+        uint32_t mask = 0;
+        while (*rest) {
+            while (*rest == ' ') rest++;
+            char* name = rest;
+            while (*rest && *rest != ' ') rest++;
+            if (*rest) *rest++ = 0;
+            if (!*name) break;
+            uint32_t cat = trace_parse_cat(name);
+            if (!cat) {
+                sh_out("[Unknown category] ");
+                sh_out(name);
+                sh_out("\n");
+                return;
             }
+            mask |= cat;
         }
-        else if (startswith(cmdline, "touch ")) {
-            char path[256];
-            make_path(cmdline + 6, path);
-            uint8_t empty[1] = {0};
-            fs_create(path, TYPE_FILE, empty, 0);
-            vga_write("[Created]\n");
+        if (!mask) mask = TRACE_CAT_ALL;
+        trace_mask = on ? (trace_mask | mask) : (trace_mask & ~mask);
+    } else if (streq(word, "clear")) {
+        trace_clear();
+    } else if (streq(word, "dump")) {
+        uint32_t n = trace_dump();
+        sh_out_num(n);
+        sh_out(" records written to COM1\n");
+        return;
+    } else if (*word) {
+        sh_out("Usage: trace [on|off <block|fs|irq|shell|all>...] | clear | dump\n");
+        return;
+    }
+
+    sh_out("Tracing:");
+    for (uint32_t i = 0; i < sizeof(trace_cat_names) / sizeof(trace_cat_names[0]); i++) {
+        if (trace_mask & (1u << i)) {
+            sh_out(" ");
+            sh_out(trace_cat_names[i]);
         }
-        else if (startswith(cmdline, "mkdir ")) {
-            char path[256];
-            make_path(cmdline + 6, path);
-            fs_create(path, TYPE_DIR, NULL, 0);
-            vga_write("[Directory Created]\n");
+    }
+    if (!trace_mask) sh_out(" off");
+    uint32_t head = trace_cpus[0].head;
+    sh_out(", records ");
+    sh_out_num(head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE);
+    if (head > TRACE_RING_SIZE) {
+        sh_out(" (");
+        sh_out_num(head - TRACE_RING_SIZE);
+        sh_out(" overwritten)");
+    }
+    sh_out("\n");
+}
+
+// 미리 읽기 캐시 통계 + 메모리에 올라온 파일 내용 ("rastat reset" 은 카운터를 0 으로)
+static void cmd_rastat(const char* args) {
+    if (streq(args, "reset")) {
+        ra_hits = ra_misses = ra_prefetched = ra_direct = 0;
+        return;
+    }
+    sh_out("Readahead: hits ");
+    sh_out_num(ra_hits);
+    sh_out(", misses ");
+    sh_out_num(ra_misses);
+    sh_out(", prefetched ");
+    sh_out_num(ra_prefetched);
+    sh_out(", direct transfers ");
+    sh_out_num(ra_direct);
+    sh_out("\nResident file data: disk ");
+    sh_out_num(fs_resident_bytes(fs_root));
+    sh_out(" bytes, tmpfs ");
+    uint32_t tmp = 0;
+    for (uint8_t m = 1; m < fs_mount_count; m++) tmp += fs_resident_bytes(fs_mounts[m].nodes);
+    sh_out_num(tmp);
+    sh_out(" bytes\n");
+}
+
+static void cmd_format(const char* args) {
+    (void)args;
+    FileNode* node = fs_root;
+    while (node) {
+        FileNode* next = node->next;
+        fs_handles_forget(node);
+        fs_node_drop(node);
+        fs_node_release(node);
+        node = next;
+    }
+    fs_root = NULL;
+    fs_save();
+    fs_create("/root", TYPE_DIR, NULL, 0);
+    sh_out("[Disk formatted]\n");
+}
+
+// 인자가 없으면 파이프 입력을 그대로 출력
+static void cmd_cat(const char* args) {
+    if (!*args) {
+        if (!sh_stdin) {
+            sh_out("Usage: cat <file>, <cmd> | cat\n");
+            return;
         }
-        else if (startswith(cmdline, "rm ")) {
-            char path[256];
-            make_path(cmdline + 3, path);
-            if (fs_delete(path)) {
-                vga_write("[Deleted]\n");
-            } else {
-                vga_write("[Delete Failed]\n");
-            }
+        sh_out_n((const char*)sh_stdin->data + sh_stdin->rpos, sh_stdin->len - sh_stdin->rpos);
+        sh_stdin->rpos = sh_stdin->len;
+        return;
+    }
+    char path[256];
+    make_path(args, path);
+    int fd = fs_open(path, FS_O_READ);
+    if (fd >= 0) {
+        uint8_t buf[512];
+        uint32_t offset = 0, n;
+        while ((n = fs_read_at(fd, offset, buf, sizeof(buf))) > 0) {
+            sh_out_n((const char*)buf, n);
+            offset += n;
         }
-        else if (startswith(cmdline, "mv ")) {
-            char oldpath[256], newpath[256];
-            const char* rest = cmdline + 3;
-            int i = 0;
-            while (*rest && *rest != ' ' && i < 255) oldpath[i++] = *rest++;
-            oldpath[i] = 0;
-            while (*rest == ' ') rest++;
-            make_path(oldpath, oldpath);
-            make_path(rest, newpath);
+        fs_close(fd);
+        sh_out("\n");
+    } else {
+        sh_out("[Not Found]\n");
+    }
+}
 
-            if (fs_move(oldpath, newpath)) {
-                vga_write("[Moved]\n");
-            } else {
-                vga_write("[Move Failed]\n");
-            }
-        }
-        else if (startswith(cmdline, "cp ")) {
-            char srcpath[256], destpath[256];
-            const char* rest = cmdline + 3;
-            int i = 0;
-            while (*rest && *rest != ' ' && i < 255) srcpath[i++] = *rest++;
-            srcpath[i] = 0;
-            while (*rest == ' ') rest++;
-            make_path(srcpath, srcpath);
-            make_path(rest, destpath);
+// 내용은 입력(키보드/스크립트 다음 줄/파이프)에서 '.' 한 줄까지
+static void cmd_ed(const char* args) {
+    char path[256];
+    make_path(args, path);
+    int fd = fs_open(path, FS_O_WRITE | FS_O_CREATE | FS_O_TRUNC);
+    if (fd < 0) {
+        sh_out("[Edit Failed]\n");
+        return;
+    }
+    if (sh_interactive()) {
+        vga_write("Enter new content. End with a single line containing only '.':\n");
+    }
+    char line[256];
+    while (sh_getline(line, 255)) {
+        if (strcmp(line, ".") == 0) break;
+        int len = strlen(line);
+        line[len++] = '\n';
+        fs_append(fd, (uint8_t*)line, len);
+    }
+    fs_close(fd);
+    sh_out("[File edited]\n");
+}
+
+static void cmd_stat(const char* args) {
+    char path[256];
+    make_path(args, path);
+    FileNode* node = fs_lookup(path);
+    if (node) {
+        path_format(node->path_id, path);
+        sh_out("Path: "); sh_out(path); sh_out("\n");
+        sh_out("Type: "); sh_out(type_to_str(node->type)); sh_out("\n");
+        sh_out("Size: ");
+        sh_out_num(node->size);
+        sh_out(" bytes\n");
+    }
+}
+
+static void cmd_touch(const char* args) {
+    char path[256];
+    make_path(args, path);
+    uint8_t empty[1] = {0};
+    fs_create(path, TYPE_FILE, empty, 0);
+    sh_out("[Created]\n");
+}
+
+static void cmd_mkdir(const char* args) {
+    char path[256];
+    make_path(args, path);
+    fs_create(path, TYPE_DIR, NULL, 0);
+    sh_out("[Directory Created]\n");
+}
+
+static void cmd_rm(const char* args) {
+    char path[256];
+    make_path(args, path);
+    if (fs_delete(path)) {
+        sh_out("[Deleted]\n");
+    } else {
+        sh_out("[Delete Failed]\n");
+    }
+}
+
+// "<a> <b>" 를 두 경로로 분리
+static void split_two_paths(const char* rest, char* first, char* second) {
+    char word[256];
+    int i = 0;
+    while (*rest && *rest != ' ' && i < 255) word[i++] = *rest++;
+    word[i] = 0;
+    while (*rest == ' ') rest++;
+    make_path(word, first);
+    make_path(rest, second);
+}
+
+static void cmd_mv(const char* args) {
+    char oldpath[256], newpath[256];
+    split_two_paths(args, oldpath, newpath);
+    if (fs_move(oldpath, newpath)) {
+        sh_out("[Moved]\n");
+    } else {
+        sh_out("[Move Failed]\n");
+    }
+}
 
-            if (fs_copy(srcpath, destpath)) {
-                vga_write("[Copied]\n");
-            } else {
-                vga_write("[Copy Failed]\n");
+static void cmd_cp(const char* args) {
+    char srcpath[256], destpath[256];
+    split_two_paths(args, srcpath, destpath);
+    if (fs_copy(srcpath, destpath)) {
+        sh_out("[Copied]\n");
+    } else {
+        sh_out("[Copy Failed]\n");
+    }
+}
+
+static void cmd_cd(const char* args) {
+    char path[256];
+    make_path(args, path);
+    strcpy(cwd, path);
+    sh_out(strcmp(args, "..") == 0 ? "[Moved Up]\n" : "[Changed Directory]\n");
+}
+
+static void cmd_run(const char* args) {
+    char path[256];
+    make_path(args, path);
+    if (!run_binary(path)) sh_out("[Binary Not Found]\n");
+}
+
+static void cmd_echo(const char* args) {
+    sh_out(args);
+    sh_out("\n");
+}
+
+// 입력의 줄/단어/바이트 수
+static void cmd_wc(const char* args) {
+    (void)args;
+    uint32_t lines = 0, words = 0, bytes = 0;
+    if (sh_stdin) {
+        bool in_word = false;
+        for (uint32_t i = sh_stdin->rpos; i < sh_stdin->len; i++) {
+            char c = (char)sh_stdin->data[i];
+            if (c == '\n') lines++;
+            if (c == ' ' || c == '\n' || c == '\t') {
+                in_word = false;
+            } else if (!in_word) {
+                in_word = true;
+                words++;
             }
         }
-        else if (strcmp(cmdline, "cd ..") == 0) {
-            int len = strlen(cwd);
-            if (len > 1) {
-                while (len > 0 && cwd[len-1] != '/') {
-                    cwd[len-1] = 0;
-                    len--;
-                }
-                if (len > 1) cwd[len-1] = 0;
-            }
-            vga_write("[Moved Up]\n");
+        bytes = sh_stdin->len - sh_stdin->rpos;
+        sh_stdin->rpos = sh_stdin->len;
+    }
+    sh_out_num(lines); sh_out(" ");
+    sh_out_num(words); sh_out(" ");
+    sh_out_num(bytes); sh_out("\n");
+}
+
+static bool line_contains(const char* line, const char* pat) {
+    int plen = strlen(pat);
+    int llen = strlen(line);
+    for (int i = 0; i + plen <= llen; i++) {
+        if (memcmp(line + i, pat, plen) == 0) return true;
+    }
+    return false;
+}
+
+// 입력 중 패턴을 포함한 줄만 출력
+static void cmd_grep(const char* args) {
+    if (!*args || !sh_stdin) {
+        sh_out("Usage: <cmd> | grep <text>\n");
+        return;
+    }
+    char line[256];
+    while (sh_getline(line, 256)) {
+        if (line_contains(line, args)) {
+            sh_out(line);
+            sh_out("\n");
         }
-        else if (startswith(cmdline, "cd ")) {
-            const char* path = cmdline + 3;
-            if (path[0] == '/') {
-                strcpy(cwd, path);
-            } else {
-                strcat(cwd, "/");
-                strcat(cwd, path);
-            }
-            vga_write("[Changed Directory]\n");
+    }
+}
+
+// 파일의 명령을 차례로 실행
+static bool sh_run_script(const char* path) {
+    if (sh_depth == SH_MAX_DEPTH) return false;
+    int fd = fs_open(path, FS_O_READ);
+    if (fd < 0) return false;
+
+    PipeBuffer* saved_in = sh_stdin;
+    sh_stdin = NULL;
+    sh_scripts[sh_depth].fd = fd;
+    sh_scripts[sh_depth].offset = 0;
+    sh_depth++;
+
+    char line[256];
+    while (sh_getline(line, 256)) {
+        sh_exec_line(line);
+    }
+
+    sh_depth--;
+    sh_stdin = saved_in;
+    fs_close(fd);
+    return true;
+}
+
+static void cmd_sh(const char* args) {
+    char path[256];
+    make_path(args, path);
+    if (!sh_run_script(path)) sh_out("[Script Not Found]\n");
+}
+
+// 명령 실행 시간 (TSC 사이클)
+static void cmd_time(const char* args) {
+    uint64_t t0 = rdtsc();
+    sh_exec_line(args);
+    uint64_t cycles = rdtsc() - t0;
+    sh_out("[");
+    sh_out_u64(cycles);
+    sh_out(" cycles]\n");
+}
+
+typedef void (*sh_cmd_fn)(const char* args);
+
+typedef struct {
+    const char* name;
+    sh_cmd_fn fn;
+    const char* usage;
+} ShCommand;
+
+static const ShCommand sh_commands[] = {
+    { "ls",       cmd_ls,       "ls" },
+    { "format",   cmd_format,   "format" },
+    { "cat",      cmd_cat,      "cat <file>" },
+    { "touch",    cmd_touch,    "touch <file>" },
+    { "mkdir",    cmd_mkdir,    "mkdir <dir>" },
+    { "rm",       cmd_rm,       "rm <path>" },
+    { "mv",       cmd_mv,       "mv <old> <new>" },
+    { "cp",       cmd_cp,       "cp <src> <dst>" },
+    { "cd",       cmd_cd,       "cd <dir>, cd .." },
+    { "run",      cmd_run,      "run <bin>" },
+    { "ed",       cmd_ed,       "ed <file>" },
+    { "stat",     cmd_stat,     "stat <file>" },
+    { "sh",       cmd_sh,       "sh <file>" },
+    { "echo",     cmd_echo,     "echo <text>" },
+    { "wc",       cmd_wc,       "wc" },
+    { "grep",     cmd_grep,     "grep <text>" },
+    { "time",     cmd_time,     "time <cmd>" },
+    { "membench", cmd_membench, "membench" },
+    { "sysbench", cmd_sysbench, "sysbench" },
+    { "rastat",   cmd_rastat,   "rastat [reset]" },
+    { "fsmem",    cmd_fsmem,    "fsmem" },
+    { "trace",    cmd_trace,    "trace [on|off <cat>|clear|dump]" },
+    { "mount",    cmd_mount,    "mount [tmpfs <path> [bytes]]" },
+    { "umount",   cmd_umount,   "umount <path>" },
+    { "help",     cmd_help,     "help" },
+};
+
+#define SH_COMMAND_COUNT (sizeof(sh_commands) / sizeof(sh_commands[0]))
+
+static void cmd_help(const char* args) {
+    (void)args;
+    sh_out("Commands:\n");
+    for (uint32_t i = 0; i < SH_COMMAND_COUNT; i++) {
+        sh_out(sh_commands[i].usage);
+        sh_out(i + 1 < SH_COMMAND_COUNT ? ", " : "\n");
+    }
+    sh_out("Pipes: <cmd> | <cmd> ...\n");
+}
+
+// 한 단계 실행: 첫 단어로 명령 테이블 검색
+static void sh_run_command(char* cmd) {
+    while (*cmd == ' ') cmd++;
+    int end = strlen(cmd);
+    while (end > 0 && cmd[end-1] == ' ') cmd[--end] = 0;
+    if (!*cmd || *cmd == '#') return;
+
+    char* args = cmd;
+    while (*args && *args != ' ') args++;
+    if (*args) *args++ = 0;
+    while (*args == ' ') args++;
+
+    for (uint32_t i = 0; i < SH_COMMAND_COUNT; i++) {
+        if (streq(sh_commands[i].name, cmd)) {
+            TRACE_BEGIN(TRACE_CAT_SHELL, TRACE_EV_SHELL_CMD, i);
+            sh_commands[i].fn(args);
+            TRACE_END(TRACE_CAT_SHELL, TRACE_EV_SHELL_CMD, i);
+            return;
         }
-        else if (startswith(cmdline, "run ")) {
-            char path[256];
-            make_path(cmdline + 4, path);
-            uint8_t bin[65536];
-            uint32_t size;
-            if (fs_read(path, bin, &size)) {
-                run_binary(bin, size);
-            } else {
-                vga_write("[Binary Not Found]\n");
-            }
+    }
+    sh_out("[Unknown Command]\n");
+}
+
+// 한 줄 실행: '|' 로 나눈 단계를 차례로, 출력은 메모리 파이프로 다음 단계에 전달
+static void sh_exec_line(const char* line) {
+    char buf[256];
+    int len = 0;
+    while (line[len] && len < 255) { buf[len] = line[len]; len++; }
+    buf[len] = 0;
+
+    char* stages[SH_MAX_STAGES];
+    int n = 0;
+    stages[n++] = buf;
+    for (char* p = buf; *p; p++) {
+        if (*p != '|') continue;
+        if (n == SH_MAX_STAGES) {
+            sh_out("[Too Many Pipe Stages]\n");
+            return;
         }
-        else {
-            vga_write("[Unknown Command]\n");
+        *p = 0;
+        stages[n++] = p + 1;
+    }
+    if (n == 1) {
+        sh_run_command(stages[0]);
+        return;
+    }
+
+    PipeBuffer pipes[2] = {{0}};
+    PipeBuffer* saved_out = sh_stdout;
+    PipeBuffer* saved_in = sh_stdin;
+    for (int i = 0; i < n; i++) {
+        sh_stdin = i ? &pipes[(i - 1) % 2] : saved_in;
+        if (i < n - 1) {
+            sh_stdout = &pipes[i % 2];
+            sh_stdout->len = 0;
+            sh_stdout->rpos = 0;
+        } else {
+            sh_stdout = saved_out;
         }
+        sh_run_command(stages[i]);
+    }
+    sh_stdout = saved_out;
+    sh_stdin = saved_in;
+    if (pipes[0].data) free(pipes[0].data);
+    if (pipes[1].data) free(pipes[1].data);
+}
+
+// 부팅 시 자동 실행 스크립트 (있을 때만)
+static void sh_autorun() {
+    if (fs_lookup(SH_AUTORUN_PATH)) sh_run_script(SH_AUTORUN_PATH);
+}
+
+static void userland() {
+    while (1) {
+        vga_write(cwd);
+        vga_write("> ");
+
+        char cmdline[256];
+        getline(cmdline, 256);
+        sh_exec_line(cmdline);
     }
 }
 
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include "io.h"  // inb/outb 필요
+#include "neuix_mem.h"
 
 #define VGA_WIDTH  80
 #define VGA_HEIGHT 25
@@ -57,12 +58,7 @@ static void vga_move_cursor() {
 static void vga_init() {
     terminal_color = vga_entry_color(COLOR_LIGHT_GREY, COLOR_BLACK);
     terminal_buffer = (uint16_t*)VGA_ADDRESS;
-    for (uint16_t y = 0; y < VGA_HEIGHT; y++) {
-        for (uint16_t x = 0; x < VGA_WIDTH; x++) {
-            const uint16_t index = y * VGA_WIDTH + x;
-            terminal_buffer[index] = vga_entry(' ', terminal_color);
-        }
-    }
+    memset16(terminal_buffer, vga_entry(' ', terminal_color), VGA_WIDTH * VGA_HEIGHT);
     terminal_row = 0;
     terminal_column = 0;
     vga_move_cursor();
@@ -98,11 +94,7 @@ static void vga_set_color(vga_color_t fg, vga_color_t bg) {
 
 // 화면 클리어
 static void vga_clear() {
-    for (uint16_t y = 0; y < VGA_HEIGHT; y++) {
-        for (uint16_t x = 0; x < VGA_WIDTH; x++) {
-            terminal_buffer[y * VGA_WIDTH + x] = vga_entry(' ', terminal_color);
-        }
-    }
+    memset16(terminal_buffer, vga_entry(' ', terminal_color), VGA_WIDTH * VGA_HEIGHT);
     terminal_row = 0;
     terminal_column = 0;
     vga_move_cursor();
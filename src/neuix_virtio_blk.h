@@ -0,0 +1,246 @@
+// neuix_virtio_blk.h – virtio-blk 드라이버 (legacy PCI 인터페이스, split virtqueue, 폴링)
+//
+// QEMU/KVM 의 반가상화 디스크. 포트 I/O 는 알림(notify) 한 번뿐이라 IDE PIO 처럼
+// 워드마다 VM exit 가 나지 않는다. submit 은 avail ring 에 넣기만 하고, 알림은 제출하는
+// 쪽이 묶음 끝에 부르는 flush 에서 한 번에 보낸다 (block_transfer, 미리 읽기 창 하나가
+// 한 번의 exit).
+// 완료는 used ring 폴링이며, 인터럽트는 VRING_AVAIL_F_NO_INTERRUPT 로 끈다.
+// 커널은 페이징 없이 물리 주소 = 가상 주소라고 가정한다.
+
+#ifndef NEUIX_VIRTIO_BLK_H
+#define NEUIX_VIRTIO_BLK_H
+
+#include "io.h"
+#include "neuix_pci.h"
+#include "neuix_block.h"
+#include "neuix_mem.h"
+#include "neuix_vga.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define VIRTIO_PCI_VENDOR          0x1AF4
+#define VIRTIO_PCI_DEVICE_BLK      0x1001   // transitional virtio-blk
+
+// legacy 레지스터 (BAR0 I/O 공간 기준)
+#define VIRTIO_REG_DEVICE_FEATURES 0x00
+#define VIRTIO_REG_GUEST_FEATURES  0x04
+#define VIRTIO_REG_QUEUE_PFN       0x08
+#define VIRTIO_REG_QUEUE_SIZE      0x0C
+#define VIRTIO_REG_QUEUE_SELECT    0x0E
+#define VIRTIO_REG_QUEUE_NOTIFY    0x10
+#define VIRTIO_REG_STATUS          0x12
+#define VIRTIO_REG_ISR             0x13
+#define VIRTIO_REG_CONFIG          0x14     // MSI-X 미사용 시
+
+#define VIRTIO_STATUS_ACK          1
+#define VIRTIO_STATUS_DRIVER       2
+#define VIRTIO_STATUS_DRIVER_OK    4
+#define VIRTIO_STATUS_FAILED       128
+
+#define VIRTIO_BLK_F_SIZE_MAX      (1u << 1)
+#define VIRTIO_BLK_F_SEG_MAX       (1u << 2)
+
+#define VIRTIO_BLK_T_IN            0
+#define VIRTIO_BLK_T_OUT           1
+
+#define VIRTQ_DESC_F_NEXT          1
+#define VIRTQ_DESC_F_WRITE         2
+#define VRING_AVAIL_F_NO_INTERRUPT 1
+
+#define VIRTIO_MAX_QUEUE           1024
+#define VIRTIO_RING_BYTES          (32 * 1024)  // 큐 크기 1024 까지의 legacy 배치
+#define VIRTIO_MAX_SEGS            8            // 요청 하나의 최대 데이터 세그먼트
+#define VIRTIO_MAX_SLOTS           64
+#define VIRTIO_MAX_REQ_SECTORS     8192
+#define VIRTIO_DEFAULT_SEG_BYTES   (4 * 1024 * 1024)
+
+typedef struct {
+    uint64_t addr;
+    uint32_t len;
+    uint16_t flags;
+    uint16_t next;
+} __attribute__((packed)) VirtqDesc;
+
+typedef struct {
+    uint16_t flags;
+    uint16_t idx;
+    uint16_t ring[];
+} __attribute__((packed)) VirtqAvail;
+
+typedef struct {
+    uint32_t id;
+    uint32_t len;
+} __attribute__((packed)) VirtqUsedElem;
+
+typedef struct {
+    uint16_t flags;
+    uint16_t idx;
+    VirtqUsedElem ring[];
+} __attribute__((packed)) VirtqUsed;
+
+typedef struct {
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t sector;
+} __attribute__((packed)) VirtioBlkHeader;
+
+static uint8_t vio_ring_mem[VIRTIO_RING_BYTES] __attribute__((aligned(4096)));
+
+static uint16_t vio_iobase = 0;
+static uint16_t vio_qsize = 0;
+static volatile VirtqDesc* vio_desc = NULL;
+static volatile VirtqAvail* vio_avail = NULL;
+static volatile VirtqUsed* vio_used = NULL;
+static uint16_t vio_used_seen = 0;
+static bool vio_kick_pending = false;
+
+// 슬롯 i 는 디스크립터 [i * (segs + 2), ...) 를 고정으로 사용: 헤더, 데이터 세그먼트들, 상태
+static uint32_t vio_segs = 1;
+static uint32_t vio_seg_bytes = VIRTIO_DEFAULT_SEG_BYTES;
+static uint32_t vio_slots = 0;
+static uint64_t vio_busy = 0;
+static VirtioBlkHeader vio_hdr[VIRTIO_MAX_SLOTS];
+static volatile uint8_t vio_status[VIRTIO_MAX_SLOTS];
+static BlockRequest* vio_reqs[VIRTIO_MAX_SLOTS];
+
+static bool virtio_blk_submit(BlockRequest* req) {
+    uint32_t slot = 0;
+    while (slot < vio_slots && (vio_busy & (1ull << slot))) slot++;
+    if (slot == vio_slots) return false;
+    uint16_t head = (uint16_t)(slot * (vio_segs + 2));
+
+    vio_hdr[slot].type = req->write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+    vio_hdr[slot].reserved = 0;
+    vio_hdr[slot].sector = req->lba;
+    vio_status[slot] = 0xFF;
+
+    uint16_t d = head;
+    vio_desc[d].addr = (uintptr_t)&vio_hdr[slot];
+    vio_desc[d].len = sizeof(VirtioBlkHeader);
+    vio_desc[d].flags = VIRTQ_DESC_F_NEXT;
+    vio_desc[d].next = d + 1;
+    d++;
+
+    // 데이터는 size_max 단위 세그먼트로 나눔
+    uintptr_t addr = (uintptr_t)req->buf;
+    uint32_t bytes = req->count * 512;
+    while (bytes) {
+        uint32_t chunk = bytes < vio_seg_bytes ? bytes : vio_seg_bytes;
+        vio_desc[d].addr = addr;
+        vio_desc[d].len = chunk;
+        vio_desc[d].flags = VIRTQ_DESC_F_NEXT | (req->write ? 0 : VIRTQ_DESC_F_WRITE);
+        vio_desc[d].next = d + 1;
+        addr += chunk;
+        bytes -= chunk;
+        d++;
+    }
+
+    vio_desc[d].addr = (uintptr_t)&vio_status[slot];
+    vio_desc[d].len = 1;
+    vio_desc[d].flags = VIRTQ_DESC_F_WRITE;
+    vio_desc[d].next = 0;
+
+    vio_reqs[slot] = req;
+    vio_busy |= 1ull << slot;
+
+    uint16_t idx = vio_avail->idx;
+    vio_avail->ring[idx % vio_qsize] = head;
+    __asm__ volatile ("" : : : "memory");   // 링 항목을 idx 보다 먼저 (x86 은 저장 순서 유지)
+    vio_avail->idx = idx + 1;
+    vio_kick_pending = true;
+    return true;
+}
+
+// avail ring 에 쌓인 요청을 장치에 알림
+static void virtio_blk_flush() {
+    if (!vio_kick_pending) return;
+    vio_kick_pending = false;
+    outw(vio_iobase + VIRTIO_REG_QUEUE_NOTIFY, 0);
+}
+
+// used ring 에서 완료 수거
+static void virtio_blk_poll() {
+    while (vio_used_seen != vio_used->idx) {
+        __asm__ volatile ("" : : : "memory");
+        uint32_t id = vio_used->ring[vio_used_seen % vio_qsize].id;
+        uint32_t slot = id / (vio_segs + 2);
+        BlockRequest* req = vio_reqs[slot];
+        req->error = vio_status[slot] != 0;
+        if (req->error) vga_write(req->write ? "[VIRTIO] Write error.\n" : "[VIRTIO] Read error.\n");
+        vio_busy &= ~(1ull << slot);
+        req->done = true;
+        vio_used_seen++;
+    }
+}
+
+static BlockDevice virtio_blk_block = { "virtio-blk", 0, VIRTIO_MAX_REQ_SECTORS, 1, virtio_blk_submit, virtio_blk_poll, virtio_blk_flush };
+
+static uint32_t virtio_align(uint32_t x) { return (x + 4095) & ~4095u; }
+
+// 장치 리셋 → 기능 협상 → 큐 0 설정 → DRIVER_OK, 블록 장치로 등록
+static bool virtio_blk_init() {
+    PciLocation loc;
+    if (!pci_find(VIRTIO_PCI_VENDOR, VIRTIO_PCI_DEVICE_BLK, 0xFF, 0xFF, 0xFFFF, &loc)) return false;
+    uint32_t bar0 = pci_read32(loc, PCI_BAR0);
+    if (!(bar0 & 1)) return false;   // legacy 인터페이스는 I/O BAR
+    pci_enable(loc);
+    vio_iobase = (uint16_t)(bar0 & 0xFFFC);
+
+    outb(vio_iobase + VIRTIO_REG_STATUS, 0);
+    outb(vio_iobase + VIRTIO_REG_STATUS, VIRTIO_STATUS_ACK);
+    outb(vio_iobase + VIRTIO_REG_STATUS, VIRTIO_STATUS_ACK | VIRTIO_STATUS_DRIVER);
+
+    // 여러 세그먼트 요청에 필요한 기능만 수락
+    uint32_t features = inl(vio_iobase + VIRTIO_REG_DEVICE_FEATURES);
+    features &= VIRTIO_BLK_F_SIZE_MAX | VIRTIO_BLK_F_SEG_MAX;
+    outl(vio_iobase + VIRTIO_REG_GUEST_FEATURES, features);
+
+    uint16_t cfg = vio_iobase + VIRTIO_REG_CONFIG;
+    uint64_t capacity = (uint64_t)inl(cfg) | ((uint64_t)inl(cfg + 4) << 32);
+    if (features & VIRTIO_BLK_F_SIZE_MAX) {
+        uint32_t size_max = inl(cfg + 8);
+        if (size_max >= 512 && size_max < vio_seg_bytes) vio_seg_bytes = size_max & ~511u;
+    }
+    vio_segs = 1;
+    if (features & VIRTIO_BLK_F_SEG_MAX) {
+        uint32_t seg_max = inl(cfg + 12);
+        vio_segs = seg_max < VIRTIO_MAX_SEGS ? (seg_max ? seg_max : 1) : VIRTIO_MAX_SEGS;
+    }
+
+    outw(vio_iobase + VIRTIO_REG_QUEUE_SELECT, 0);
+    vio_qsize = inw(vio_iobase + VIRTIO_REG_QUEUE_SIZE);
+    // 요청 하나에 헤더 + 데이터 + 상태, 최소 3개 디스크립터
+    if (vio_qsize < 3 || vio_qsize > VIRTIO_MAX_QUEUE) {
+        outb(vio_iobase + VIRTIO_REG_STATUS, VIRTIO_STATUS_FAILED);
+        return false;
+    }
+    if (vio_qsize < vio_segs + 2) vio_segs = vio_qsize - 2;
+
+    // legacy 배치: 디스크립터 표, avail ring, (4K 정렬) used ring
+    memset(vio_ring_mem, 0, sizeof(vio_ring_mem));
+    uint32_t avail_off = 16 * vio_qsize;
+    uint32_t used_off = virtio_align(avail_off + 6 + 2 * vio_qsize);
+    vio_desc = (volatile VirtqDesc*)vio_ring_mem;
+    vio_avail = (volatile VirtqAvail*)(vio_ring_mem + avail_off);
+    vio_used = (volatile VirtqUsed*)(vio_ring_mem + used_off);
+    vio_avail->flags = VRING_AVAIL_F_NO_INTERRUPT;
+    vio_used_seen = 0;
+    vio_busy = 0;
+    outl(vio_iobase + VIRTIO_REG_QUEUE_PFN, (uint32_t)(uintptr_t)vio_ring_mem >> 12);
+
+    vio_slots = vio_qsize / (vio_segs + 2);
+    if (vio_slots > VIRTIO_MAX_SLOTS) vio_slots = VIRTIO_MAX_SLOTS;
+
+    uint32_t max_sectors = (uint32_t)(((uint64_t)vio_segs * vio_seg_bytes) / 512);
+    if (max_sectors > VIRTIO_MAX_REQ_SECTORS) max_sectors = VIRTIO_MAX_REQ_SECTORS;
+    virtio_blk_block.sectors = capacity;
+    virtio_blk_block.max_sectors = max_sectors;
+    virtio_blk_block.queue_depth = vio_slots;
+
+    outb(vio_iobase + VIRTIO_REG_STATUS, VIRTIO_STATUS_ACK | VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_DRIVER_OK);
+    block_dev = &virtio_blk_block;
+    vga_write("[VIRTIO] virtio-blk disk ready\n");
+    return true;
+}
+
+#endif // NEUIX_VIRTIO_BLK_H
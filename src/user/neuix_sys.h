@@ -0,0 +1,107 @@
+// neuix_sys.h – Neuix 바이너리용 시스템 콜 스텁 (커널 주소에 링크하지 않음)
+//
+// 사용법:
+//   #include "neuix_sys.h"
+//   static int main(void) { sys_puts("hello\n"); return 0; }
+//   NEUIX_ENTRY(main)
+//
+// 바이너리는 0x100000 에 그대로 적재되어 첫 바이트부터 실행되므로
+// _start 가 맨 앞에 오도록 .text.entry 섹션을 링커 스크립트 첫 줄에 둘 것.
+// 번호/규약은 커널의 neuix_syscall.h 와 동일하다.
+
+#ifndef NEUIX_SYS_H
+#define NEUIX_SYS_H
+
+#include <stdint.h>
+
+#define SYS_NOP       0
+#define SYS_EXIT      1
+#define SYS_WRITE     2
+#define SYS_GETLINE   3
+#define SYS_OPEN      4
+#define SYS_CLOSE     5
+#define SYS_READ_AT   6
+#define SYS_WRITE_AT  7
+#define SYS_APPEND    8
+#define SYS_TRUNCATE  9
+#define SYS_SIZE      10
+#define SYS_TIME      11
+
+// sys_open 플래그
+#define O_READ   (1 << 0)
+#define O_WRITE  (1 << 1)
+#define O_CREATE (1 << 2)
+#define O_TRUNC  (1 << 3)
+
+typedef int32_t (*neuix_fast_fn)(void);
+
+// 커널이 넘겨준 빠른 진입점 (없으면 int 0x80 사용)
+static neuix_fast_fn neuix_fast = 0;
+
+static inline int32_t neuix_syscall(uint32_t n, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4) {
+    int32_t ret;
+    if (neuix_fast) {
+        __asm__ volatile ("call *%6"
+                          : "=a"(ret)
+                          : "a"(n), "b"(a1), "c"(a2), "d"(a3), "S"(a4), "D"(neuix_fast)
+                          : "memory");
+    } else {
+        __asm__ volatile ("int $0x80"
+                          : "=a"(ret)
+                          : "a"(n), "b"(a1), "c"(a2), "d"(a3), "S"(a4)
+                          : "memory");
+    }
+    return ret;
+}
+
+static inline void sys_exit(int code) {
+    neuix_syscall(SYS_EXIT, (uint32_t)code, 0, 0, 0);
+    for (;;);
+}
+static inline int sys_write(const char* buf, uint32_t len) {
+    return neuix_syscall(SYS_WRITE, (uint32_t)buf, len, 0, 0);
+}
+static inline int sys_puts(const char* s) {
+    uint32_t len = 0;
+    while (s[len]) len++;
+    return sys_write(s, len);
+}
+static inline int sys_getline(char* buf, int max) {
+    return neuix_syscall(SYS_GETLINE, (uint32_t)buf, (uint32_t)max, 0, 0);
+}
+static inline int sys_open(const char* path, uint32_t flags) {
+    return neuix_syscall(SYS_OPEN, (uint32_t)path, flags, 0, 0);
+}
+static inline void sys_close(int fd) {
+    neuix_syscall(SYS_CLOSE, (uint32_t)fd, 0, 0, 0);
+}
+static inline uint32_t sys_read_at(int fd, uint32_t offset, void* buf, uint32_t len) {
+    return (uint32_t)neuix_syscall(SYS_READ_AT, (uint32_t)fd, offset, (uint32_t)buf, len);
+}
+static inline uint32_t sys_write_at(int fd, uint32_t offset, const void* buf, uint32_t len) {
+    return (uint32_t)neuix_syscall(SYS_WRITE_AT, (uint32_t)fd, offset, (uint32_t)buf, len);
+}
+static inline uint32_t sys_append(int fd, const void* buf, uint32_t len) {
+    return (uint32_t)neuix_syscall(SYS_APPEND, (uint32_t)fd, (uint32_t)buf, len, 0);
+}
+static inline int sys_truncate(int fd, uint32_t size) {
+    return neuix_syscall(SYS_TRUNCATE, (uint32_t)fd, size, 0, 0);
+}
+static inline uint32_t sys_size(int fd) {
+    return (uint32_t)neuix_syscall(SYS_SIZE, (uint32_t)fd, 0, 0, 0);
+}
+static inline uint64_t sys_time(void) {
+    uint64_t t = 0;
+    neuix_syscall(SYS_TIME, (uint32_t)&t, 0, 0, 0);
+    return t;
+}
+
+// 진입점 정의: 빠른 진입점 저장 후 main 실행, 반환값으로 종료
+#define NEUIX_ENTRY(main_fn)                                              \
+    __attribute__((section(".text.entry"), used))                         \
+    void _start(neuix_fast_fn fast) {                                     \
+        neuix_fast = fast;                                                \
+        sys_exit(main_fn());                                              \
+    }
+
+#endif // NEUIX_SYS_H